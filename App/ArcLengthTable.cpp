@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ArcLengthTable.h"
+
+using namespace slm;
+
+ArcLengthTable::ArcLengthTable() : mStep(1)
+{
+}
+
+ArcLengthTable::ArcLengthTable(const GeometryView &geom) : mStep(1)
+{
+    this->build(geom);
+}
+
+ArcLengthTable::~ArcLengthTable()
+{
+}
+
+void ArcLengthTable::build(const GeometryView &geom)
+{
+    mCumLength.clear();
+
+    if(geom.rows < 2 || geom.cols < 2)
+        return;
+
+    uint64_t numSegs;
+
+    if(geom.type == LayerGeometry::HATCH) {
+        numSegs = geom.rows / 2;
+        mStep = 2;
+    } else if(geom.type == LayerGeometry::POLYGON) {
+        numSegs = geom.rows - 1;
+        mStep = 1;
+    } else {
+        return;
+    }
+
+    const float *x = geom.data;
+    const float *y = geom.data + geom.rows;
+
+    mCumLength.resize(numSegs + 1);
+    mCumLength[0] = 0.0;
+
+    for(uint64_t i = 0; i < numSegs; i++) {
+
+        const uint64_t row = i * mStep;
+        const double dx = double(x[row + 1]) - double(x[row]);
+        const double dy = double(y[row + 1]) - double(y[row]);
+
+        mCumLength[i + 1] = mCumLength[i] + std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+bool ArcLengthTable::locate(double dist, uint64_t &segIdx, double &segDist) const
+{
+    const uint64_t numSegs = this->numSegments();
+
+    if(numSegs == 0)
+        return false;
+
+    // The last scan vector starting at or before the distance
+    const auto it = std::upper_bound(mCumLength.begin(), mCumLength.begin() + numSegs, dist);
+
+    segIdx = (it == mCumLength.begin()) ? 0 : (it - mCumLength.begin()) - 1;
+
+    const double segLength = mCumLength[segIdx + 1] - mCumLength[segIdx];
+    segDist = std::min(std::max(dist - mCumLength[segIdx], 0.0), segLength);
+
+    return true;
+}
+
+uint64_t ArcLengthTable::lowerBound(double dist) const
+{
+    if(mCumLength.empty())
+        return 0;
+
+    return std::lower_bound(mCumLength.begin() + 1, mCumLength.end(), dist) - (mCumLength.begin() + 1);
+}
@@ -0,0 +1,65 @@
+#ifndef SLM_ARCLENGTHTABLE_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_ARCLENGTHTABLE_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Layer.h"
+
+namespace slm
+{
+
+/**
+ * @brief The ArcLengthTable class holds the cumulative length of the scan vectors along the path of a geometry, so
+ * that the scan vector at a distance along the path is found by a binary search rather than summing the length of
+ * each preceding vector. Hatch vectors are formed by consecutive pairs of points, whilst contours are formed by
+ * consecutive points. Other geometry has no scan vectors.
+ */
+class SLM_EXPORT ArcLengthTable
+{
+public:
+    typedef std::shared_ptr<const ArcLengthTable> ConstPtr;
+
+    ArcLengthTable();
+    explicit ArcLengthTable(const GeometryView &geom);
+    ~ArcLengthTable();
+
+public:
+    void build(const GeometryView &geom);
+
+    uint64_t numSegments() const { return mCumLength.empty() ? 0 : mCumLength.size() - 1; }
+    double length() const { return mCumLength.empty() ? 0.0 : mCumLength.back(); }
+
+    // Distance along the path at the start of the scan vector
+    double segmentStart(uint64_t segIdx) const { return mCumLength[segIdx]; }
+
+    // Rows of the geometry coordinates forming the start and end of the scan vector
+    uint64_t segmentFirstRow(uint64_t segIdx) const { return segIdx * mStep; }
+    uint64_t segmentLastRow(uint64_t segIdx) const { return segIdx * mStep + 1; }
+
+    /**
+     * Locates the scan vector at the distance along the path. Distances beyond the path locate the end of the last
+     * scan vector.
+     * @param dist - Distance along the path
+     * @param segIdx - Index of the scan vector
+     * @param segDist - Distance along the scan vector
+     * @return false if the geometry has no scan vectors
+     */
+    bool locate(double dist, uint64_t &segIdx, double &segDist) const;
+
+    // Index of the first scan vector ending at or after the distance, or numSegments() if there is none
+    uint64_t lowerBound(double dist) const;
+
+protected:
+    std::vector<double> mCumLength; // Distance at the start of each scan vector and the total length
+    uint64_t mStep;                 // Number of rows between the start of consecutive scan vectors
+};
+
+} // End of Namespace slm
+
+#endif // SLM_ARCLENGTHTABLE_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,303 @@
+#include <algorithm>
+
+#include "Build.h"
+
+using namespace slm;
+
+namespace {
+
+bool compareLayerZ(const Layer::Ptr &layer, uint64_t z)
+{
+    return layer->getZ() < z;
+}
+
+bool compareZLayer(uint64_t z, const Layer::Ptr &layer)
+{
+    return z < layer->getZ();
+}
+
+} // End of anonymous namespace
+
+Build::Build() : mHeader()
+{
+}
+
+Build::Build(const Header &header,
+             const std::vector<Model::Ptr> &models,
+             const std::vector<Layer::Ptr> &layers) : mHeader(header)
+{
+    this->setModels(models);
+    this->setLayers(layers);
+}
+
+Build::~Build()
+{
+}
+
+void Build::clear()
+{
+    mModels.clear();
+    mModelIndex.clear();
+    mBuildStyleIndex.clear();
+
+    mLayers.clear();
+    mLayersByZ.clear();
+    mLayerIndex.clear();
+    mTopLayerById.reset();
+}
+
+uint64_t Build::reindex()
+{
+    const std::vector<Model::Ptr> models(mModels);
+    const std::vector<Layer::Ptr> layers(mLayers);
+
+    return this->setModels(models) + this->setLayers(layers);
+}
+
+bool Build::indexModel(const Model::Ptr &model)
+{
+    // Only the first model of each id is indexed
+    if(!mModelIndex.emplace(model->getId(), model).second)
+        return false;
+
+    for(auto bstyle : model->getBuildStyles())
+        mBuildStyleIndex.emplace(std::make_pair(model->getId(), bstyle->id), bstyle);
+
+    return true;
+}
+
+bool Build::indexLayer(const Layer::Ptr &layer)
+{
+    if(!mLayerIndex.emplace(layer->getLayerId(), layer).second)
+        return false;
+
+    if(!mTopLayerById || layer->getLayerId() > mTopLayerById->getLayerId())
+        mTopLayerById = layer;
+
+    return true;
+}
+
+int64_t Build::addModel(Model::Ptr model)
+{
+    if(!model || mModelIndex.count(model->getId()))
+        return -1;
+
+    mModels.push_back(model);
+    this->indexModel(model);
+
+    return mModels.size();
+}
+
+bool Build::removeModel(uint64_t mid)
+{
+    auto it = mModelIndex.find(mid);
+
+    if(it == mModelIndex.end())
+        return false;
+
+    for(auto bstyle : it->second->getBuildStyles())
+        mBuildStyleIndex.erase(std::make_pair(mid, bstyle->id));
+
+    mModels.erase(std::find(mModels.begin(), mModels.end(), it->second));
+    mModelIndex.erase(it);
+
+    // A following model with the same id takes the place of the removed model
+    auto dup = std::find_if(mModels.begin(), mModels.end(), [mid](const Model::Ptr &model) {
+        return model->getId() == mid;
+    });
+
+    if(dup != mModels.end())
+        this->indexModel(*dup);
+
+    return true;
+}
+
+uint64_t Build::setModels(const std::vector<Model::Ptr> &models)
+{
+    mModels.clear();
+    mModelIndex.clear();
+    mBuildStyleIndex.clear();
+
+    mModels.reserve(models.size());
+    mModelIndex.reserve(models.size());
+
+    uint64_t numDuplicates = 0;
+
+    for(auto model : models) {
+
+        if(!model)
+            continue;
+
+        mModels.push_back(model);
+
+        if(!this->indexModel(model))
+            numDuplicates++;
+    }
+
+    return numDuplicates;
+}
+
+Model::Ptr Build::getModelById(uint64_t mid) const
+{
+    auto it = mModelIndex.find(mid);
+    return (it != mModelIndex.end()) ? it->second : Model::Ptr();
+}
+
+BuildStyle::Ptr Build::getBuildStyle(uint64_t mid, uint64_t bid) const
+{
+    auto it = mBuildStyleIndex.find(std::make_pair(mid, bid));
+    return (it != mBuildStyleIndex.end()) ? it->second : BuildStyle::Ptr();
+}
+
+void Build::insertLayerByZ(const Layer::Ptr &layer)
+{
+    // Layers are usually added in order, so are appended without searching
+    if(mLayersByZ.empty() || mLayersByZ.back()->getZ() <= layer->getZ()) {
+        mLayersByZ.push_back(layer);
+        return;
+    }
+
+    auto pos = std::upper_bound(mLayersByZ.begin(), mLayersByZ.end(), layer->getZ(), compareZLayer);
+    mLayersByZ.insert(pos, layer);
+}
+
+int64_t Build::addLayer(Layer::Ptr layer)
+{
+    if(!layer || mLayerIndex.count(layer->getLayerId()))
+        return -1;
+
+    mLayers.push_back(layer);
+    this->indexLayer(layer);
+    this->insertLayerByZ(layer);
+
+    return mLayers.size();
+}
+
+bool Build::removeLayer(uint64_t layerId)
+{
+    auto it = mLayerIndex.find(layerId);
+
+    if(it == mLayerIndex.end())
+        return false;
+
+    const Layer::Ptr layer = it->second;
+    mLayerIndex.erase(it);
+
+    mLayers.erase(std::find(mLayers.begin(), mLayers.end(), layer));
+    mLayersByZ.erase(std::find(mLayersByZ.begin(), mLayersByZ.end(), layer));
+
+    // A following layer with the same id takes the place of the removed layer
+    auto dup = std::find_if(mLayers.begin(), mLayers.end(), [layerId](const Layer::Ptr &other) {
+        return other->getLayerId() == layerId;
+    });
+
+    if(dup != mLayers.end())
+        mLayerIndex.emplace(layerId, *dup);
+
+    if(mTopLayerById == layer)
+        mTopLayerById = getTopLayerById(mLayers);
+
+    return true;
+}
+
+uint64_t Build::setLayers(const std::vector<Layer::Ptr> &layers)
+{
+    mLayers.clear();
+    mLayersByZ.clear();
+    mLayerIndex.clear();
+    mTopLayerById.reset();
+
+    mLayers.reserve(layers.size());
+    mLayerIndex.reserve(layers.size());
+
+    uint64_t numDuplicates = 0;
+
+    for(auto layer : layers) {
+
+        if(!layer)
+            continue;
+
+        mLayers.push_back(layer);
+
+        if(!this->indexLayer(layer))
+            numDuplicates++;
+    }
+
+    // The z index is sorted once rather than inserting each layer, retaining the order of layers at the same z
+    mLayersByZ = mLayers;
+
+    std::stable_sort(mLayersByZ.begin(), mLayersByZ.end(), [](const Layer::Ptr &a, const Layer::Ptr &b) {
+        return a->getZ() < b->getZ();
+    });
+
+    return numDuplicates;
+}
+
+Layer::Ptr Build::getLayerById(uint64_t layerId) const
+{
+    auto it = mLayerIndex.find(layerId);
+    return (it != mLayerIndex.end()) ? it->second : Layer::Ptr();
+}
+
+Layer::Ptr Build::getLayerByZ(uint64_t z) const
+{
+    auto it = std::lower_bound(mLayersByZ.begin(), mLayersByZ.end(), z, compareLayerZ);
+
+    if(it == mLayersByZ.end() || (*it)->getZ() != z)
+        return Layer::Ptr();
+
+    return *it;
+}
+
+std::vector<Layer::Ptr> Build::getLayersInZRange(uint64_t zMin, uint64_t zMax) const
+{
+    if(zMin > zMax)
+        return std::vector<Layer::Ptr>();
+
+    auto first = std::lower_bound(mLayersByZ.begin(), mLayersByZ.end(), zMin, compareLayerZ);
+    auto last = std::upper_bound(first, mLayersByZ.end(), zMax, compareZLayer);
+
+    return std::vector<Layer::Ptr>(first, last);
+}
+
+Layer::Ptr Build::getTopLayerByPosition() const
+{
+    if(mLayersByZ.empty())
+        return Layer::Ptr();
+
+    // The first layer at the highest position
+    return this->getLayerByZ(mLayersByZ.back()->getZ());
+}
+
+Layer::Ptr Build::getTopLayerById() const
+{
+    return mTopLayerById;
+}
+
+Layer::Ptr Build::getTopLayerByPosition(const std::vector<Layer::Ptr> &layers)
+{
+    // The first layer at the highest position, which matches the indexed lookup including layers at z = 0
+    Layer::Ptr fndLayer;
+
+    for(auto layer : layers) {
+
+        if(!fndLayer || layer->getZ() > fndLayer->getZ())
+            fndLayer = layer;
+    }
+
+    return fndLayer;
+}
+
+Layer::Ptr Build::getTopLayerById(const std::vector<Layer::Ptr> &layers)
+{
+    // The first layer with the highest id, which matches the indexed lookup including a layer id of 0
+    Layer::Ptr fndLayer;
+
+    for(auto layer : layers) {
+
+        if(!fndLayer || layer->getLayerId() > fndLayer->getLayerId())
+            fndLayer = layer;
+    }
+
+    return fndLayer;
+}
@@ -0,0 +1,150 @@
+#ifndef SLM_BUILD_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_BUILD_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Header.h"
+#include "Layer.h"
+#include "Model.h"
+
+namespace slm
+{
+
+/**
+ * @brief The Build class owns the Header, models and layers of a build. The models are indexed by their id and the
+ * build styles by their model and build style id, whilst the layers are indexed by their id and kept sorted by their
+ * z position, so that lookups do not search the build and the layers may be iterated in order without sorting.
+ *
+ * The indexes are updated when models or layers are added through the Build. Models or layers modified afterwards,
+ * such as adding build styles to a model or changing the z position of a layer, require a call to reindex().
+ *
+ * Models or layers set together which share an id are all retained, but only the first of each id is indexed. The
+ * number of duplicates is returned when setting them and by numDuplicateModels() and numDuplicateLayers(), whilst
+ * the Validator reports each duplicate layer.
+ */
+class SLM_EXPORT Build
+{
+public:
+    typedef std::shared_ptr<Build> Ptr;
+
+    Build();
+    Build(const Header &header, const std::vector<Model::Ptr> &models, const std::vector<Layer::Ptr> &layers);
+    ~Build();
+
+public:
+    void clear();
+
+    /**
+     * Rebuilds all indexes after the models or layers were modified
+     * @return The number of models and layers with a duplicate id
+     */
+    uint64_t reindex();
+
+    const Header & header() const { return mHeader; }
+    Header & headerRef() { return mHeader; }
+    void setHeader(const Header &header) { mHeader = header; }
+
+    /*
+     * Models
+     */
+
+    /**
+     * Adds a model to the build
+     * @return The number of models or -1 if a model with the same id exists
+     */
+    int64_t addModel(Model::Ptr model);
+    bool removeModel(uint64_t mid);
+
+    /**
+     * Replaces the models of the build
+     * @return The number of models with the id of a previous model
+     */
+    uint64_t setModels(const std::vector<Model::Ptr> &models);
+
+    const std::vector<Model::Ptr> & models() const { return mModels; }
+    uint64_t numModels() const { return mModels.size(); }
+    uint64_t numDuplicateModels() const { return mModels.size() - mModelIndex.size(); }
+
+    Model::Ptr getModelById(uint64_t mid) const;
+    BuildStyle::Ptr getBuildStyle(uint64_t mid, uint64_t bid) const;
+
+    /*
+     * Layers
+     */
+
+    /**
+     * Adds a layer to the build, which is inserted into the z index after any layers at the same position
+     * @return The number of layers or -1 if a layer with the same id exists
+     */
+    int64_t addLayer(Layer::Ptr layer);
+    bool removeLayer(uint64_t layerId);
+
+    /**
+     * Replaces the layers of the build
+     * @return The number of layers with the id of a previous layer
+     */
+    uint64_t setLayers(const std::vector<Layer::Ptr> &layers);
+
+    // Layers in the order they were added
+    const std::vector<Layer::Ptr> & layers() const { return mLayers; }
+
+    // Layers sorted by their z position
+    const std::vector<Layer::Ptr> & layersByZ() const { return mLayersByZ; }
+
+    uint64_t numLayers() const { return mLayers.size(); }
+    uint64_t numDuplicateLayers() const { return mLayers.size() - mLayerIndex.size(); }
+
+    Layer::Ptr getLayerById(uint64_t layerId) const;
+
+    // Returns the first layer at the z position or a null pointer
+    Layer::Ptr getLayerByZ(uint64_t z) const;
+
+    // Returns the layers within the inclusive z interval sorted by their z position
+    std::vector<Layer::Ptr> getLayersInZRange(uint64_t zMin, uint64_t zMax) const;
+
+    /*
+     * The first layer with the highest z position or id, or a null pointer without layers. The static versions apply
+     * the same definition to the layers given.
+     */
+    Layer::Ptr getTopLayerByPosition() const;
+    Layer::Ptr getTopLayerById() const;
+
+    static Layer::Ptr getTopLayerByPosition(const std::vector<Layer::Ptr> &layers);
+    static Layer::Ptr getTopLayerById(const std::vector<Layer::Ptr> &layers);
+
+protected:
+    struct BuildStyleKeyHash
+    {
+        size_t operator()(const std::pair<uint64_t, uint64_t> &key) const
+        {
+            return std::hash<uint64_t>()(key.first * 0x9E3779B97F4A7C15ULL ^ key.second);
+        }
+    };
+
+    typedef std::unordered_map<std::pair<uint64_t, uint64_t>, BuildStyle::Ptr, BuildStyleKeyHash> BuildStyleIndex;
+
+    // Adds an entry to the indexes, returning false if an entry with the same id is already indexed
+    bool indexModel(const Model::Ptr &model);
+    bool indexLayer(const Layer::Ptr &layer);
+    void insertLayerByZ(const Layer::Ptr &layer);
+
+    Header mHeader;
+
+    std::vector<Model::Ptr> mModels;
+    std::unordered_map<uint64_t, Model::Ptr> mModelIndex;
+    BuildStyleIndex mBuildStyleIndex;
+
+    std::vector<Layer::Ptr> mLayers;
+    std::vector<Layer::Ptr> mLayersByZ;
+    std::unordered_map<uint64_t, Layer::Ptr> mLayerIndex;
+    Layer::Ptr mTopLayerById;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_BUILD_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <filesystem/fwd.h>
+#include <filesystem/resolver.h>
+#include <filesystem/path.h>
+
+#include "MappedFile.h"
+#include "NativeFormat.h"
+#include "NativeReader.h"
+#include "NativeWriter.h"
+
+#include "BuildCache.h"
+
+namespace fs = filesystem;
+
+using namespace slm;
+
+namespace {
+
+const char *ManifestName = "manifest.txt";
+const char *EntryExtension = ".slmn";
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+Header sourceHeader(const base::Reader &reader, const std::string &path)
+{
+    const NativeReader *nativeReader = dynamic_cast<const NativeReader *>(&reader);
+
+    if(nativeReader)
+        return nativeReader->getHeader();
+
+    // The header of other formats is not available from the reader, where a z unit of 0 is unknown
+    Header header;
+    header.fileName = path;
+    header.creator = "libSLM";
+    header.vMajor = 1;
+    header.vMinor = 0;
+    header.zUnit = 0;
+
+    return header;
+}
+
+bool modificationTime(const std::string &path, int64_t &mtime)
+{
+#ifdef _WIN32
+    struct _stat64 st;
+    if(_stat64(path.c_str(), &st) != 0)
+        return false;
+#else
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0)
+        return false;
+#endif
+
+    mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+}
+
+std::string toHex(uint64_t value)
+{
+    std::ostringstream str;
+    str << std::hex << std::setfill('0') << std::setw(16) << value;
+    return str.str();
+}
+
+} // End of anonymous namespace
+
+const size_t BuildCache::SampleBlockSize;
+const size_t BuildCache::NumStridedBlocks;
+
+BuildCache::BuildCache(const std::string &cacheDir, uint64_t maxSize) : mCacheDir(cacheDir),
+                                                                        mMaxSize(maxSize),
+                                                                        mUseCounter(0)
+{
+    fs::path dirPath(mCacheDir);
+
+    if(!dirPath.exists() && !fs::create_directories(dirPath))
+        std::cerr << "Cache directory '" << mCacheDir << "' could not be created" << std::endl;
+
+    this->loadManifest();
+}
+
+BuildCache::~BuildCache()
+{
+}
+
+uint64_t BuildCache::hash(const uint8_t *data, size_t len, uint64_t seed)
+{
+    const uint64_t prime1 = 0x9e3779b97f4a7c15ULL;
+    const uint64_t prime2 = 0xc2b2ae3d27d4eb4fULL;
+
+    // Four independent lanes are hashed in parallel over blocks of 32 bytes
+    uint64_t lanes[4] = {seed + prime1, seed + prime2, seed, seed - prime1};
+
+    size_t pos = 0;
+
+    for(; pos + 32 <= len; pos += 32) {
+        for(int i = 0; i < 4; i++) {
+            uint64_t word;
+            std::memcpy(&word, data + pos + i * 8, sizeof(word));
+            lanes[i] = rotl(lanes[i] + word * prime2, 31) * prime1;
+        }
+    }
+
+    uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    h += static_cast<uint64_t>(len);
+
+    for(; pos < len; pos++)
+        h = rotl(h ^ (data[pos] * prime1), 11) * prime2;
+
+    return mix(h);
+}
+
+bool BuildCache::contentHash(const std::string &path, uint64_t &hash)
+{
+    MappedFile file;
+
+    if(!file.open(path))
+        return false;
+
+    hash = BuildCache::hash(file.data(), file.size());
+    return true;
+}
+
+std::string BuildCache::key(const std::string &path, const std::string &format) const
+{
+    int64_t mtime;
+
+    if(!modificationTime(path, mtime))
+        return std::string();
+
+    MappedFile file;
+
+    if(!file.open(path))
+        return std::string();
+
+    const uint8_t *data = file.data();
+    const uint64_t size = file.size();
+
+    // Only the head, the tail and blocks at a fixed stride are hashed, so only these pages of the file are read
+    uint64_t sampleHash;
+
+    if(size <= SampleBlockSize * (NumStridedBlocks + 2)) {
+        sampleHash = BuildCache::hash(data, size);
+    } else {
+        sampleHash = BuildCache::hash(data, SampleBlockSize);
+        sampleHash = BuildCache::hash(data + size - SampleBlockSize, SampleBlockSize, sampleHash);
+
+        const uint64_t stride = (size - SampleBlockSize) / (NumStridedBlocks + 1);
+
+        for(size_t i = 1; i <= NumStridedBlocks; i++)
+            sampleHash = BuildCache::hash(data + i * stride, SampleBlockSize, sampleHash);
+    }
+
+    // The format and version of the cached entries are combined with the file size and modification time
+    std::ostringstream formatId;
+    formatId << format << "/native-" << native::Version;
+
+    const std::string formatStr = formatId.str();
+
+    uint64_t metaHash = BuildCache::hash(reinterpret_cast<const uint8_t *>(formatStr.data()), formatStr.size());
+    metaHash = mix(metaHash ^ size);
+    metaHash = mix(metaHash ^ static_cast<uint64_t>(mtime));
+
+    return toHex(sampleHash) + toHex(metaHash);
+}
+
+std::string BuildCache::entryPath(const std::string &key) const
+{
+    return (fs::path(mCacheDir) / fs::path(key + EntryExtension)).str();
+}
+
+std::string BuildCache::manifestPath() const
+{
+    return (fs::path(mCacheDir) / fs::path(ManifestName)).str();
+}
+
+bool BuildCache::contains(const std::string &key) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.find(key) != mEntries.end() && fs::path(entryPath(key)).exists();
+}
+
+uint64_t BuildCache::totalSize() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    uint64_t total = 0;
+
+    for(const auto &entry : mEntries)
+        total += entry.second.size;
+
+    return total;
+}
+
+size_t BuildCache::numEntries() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.size();
+}
+
+void BuildCache::setMaxSize(uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mMaxSize = bytes;
+    this->evict();
+    this->saveManifest();
+}
+
+base::Reader::Ptr BuildCache::open(const base::Reader::Ptr &reader, const std::string &format, const Header &header)
+{
+    return this->openEntry(reader, format, &header);
+}
+
+base::Reader::Ptr BuildCache::open(const base::Reader::Ptr &reader, const std::string &format)
+{
+    return this->openEntry(reader, format, nullptr);
+}
+
+base::Reader::Ptr BuildCache::openEntry(const base::Reader::Ptr &reader, const std::string &format,
+                                        const Header *header)
+{
+    if(!reader)
+        return base::Reader::Ptr();
+
+    const std::string path = reader->getFilePath();
+    std::string entryKey = this->key(path, format);
+
+    // The source file cannot be hashed, so is translated without the cache
+    if(entryKey.empty())
+        return reader->parse() < 0 ? base::Reader::Ptr() : reader;
+
+    uint64_t fileHash = 0;
+    bool hashed = false;
+
+    Entry entry;
+    bool found;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto it = mEntries.find(entryKey);
+        found = it != mEntries.end();
+
+        if(found)
+            entry = it->second;
+    }
+
+    /*
+     * An entry of the same source file is trusted. Another file matching the key is compared by its full hash, and
+     * on a collision the full hash is appended to the key, so that both files may be cached.
+     */
+    if(found && entry.source != path) {
+
+        if(!BuildCache::contentHash(path, fileHash))
+            return reader->parse() < 0 ? base::Reader::Ptr() : reader;
+
+        hashed = true;
+
+        if(fileHash != entry.contentHash)
+            entryKey += toHex(fileHash);
+    }
+
+    if(this->contains(entryKey)) {
+
+        std::shared_ptr<NativeReader> cachedReader = std::make_shared<NativeReader>(this->entryPath(entryKey));
+
+        if(cachedReader->parse() > 0) {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            auto it = mEntries.find(entryKey);
+
+            if(it != mEntries.end())
+                it->second.source = path;
+
+            this->touch(entryKey);
+            this->saveManifest();
+            return cachedReader;
+        }
+
+        // The entry is corrupt and is translated again
+        std::cerr << "Cache entry '" << entryKey << "' could not be read" << std::endl;
+        this->remove(entryKey);
+    }
+
+    if(reader->parse() < 0)
+        return base::Reader::Ptr();
+
+    if(hashed || BuildCache::contentHash(path, fileHash))
+        this->store(entryKey, *reader, fileHash, header ? *header : sourceHeader(*reader, path));
+
+    return reader;
+}
+
+int BuildCache::store(const std::string &key, base::Reader &reader, uint64_t contentHash, const Header &header)
+{
+    const std::string path = this->entryPath(key);
+    const std::string tmpPath = path + ".tmp";
+
+    const std::vector<Layer::Ptr> layers = reader.getLayers();
+
+    NativeWriter writer(tmpPath);
+    writer.setLayerThickness(reader.getLayerThickness());
+    writer.write(header, reader.getModels(), layers);
+
+    // The entry is written to a temporary file first, so that a partially written entry is never read
+    if(writer.hasWriteFailed() || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Cache entry '" << key << "' could not be written" << std::endl;
+        std::remove(tmpPath.c_str());
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    Entry entry;
+    entry.size = fs::path(path).file_size();
+    entry.lastUsed = 0;
+    entry.contentHash = contentHash;
+    entry.source = reader.getFilePath();
+
+    mEntries[key] = entry;
+
+    this->touch(key);
+    this->evict();
+    this->saveManifest();
+
+    return 1;
+}
+
+bool BuildCache::remove(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mEntries.find(key);
+
+    if(it == mEntries.end())
+        return false;
+
+    std::remove(entryPath(key).c_str());
+    mEntries.erase(it);
+
+    this->saveManifest();
+
+    return true;
+}
+
+void BuildCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for(const auto &entry : mEntries)
+        std::remove(entryPath(entry.first).c_str());
+
+    mEntries.clear();
+
+    this->saveManifest();
+}
+
+void BuildCache::touch(const std::string &key)
+{
+    auto it = mEntries.find(key);
+
+    if(it != mEntries.end())
+        it->second.lastUsed = ++mUseCounter;
+}
+
+void BuildCache::evict()
+{
+    if(mMaxSize == 0)
+        return;
+
+    uint64_t total = 0;
+
+    std::vector<std::pair<uint64_t, std::string>> order;
+    order.reserve(mEntries.size());
+
+    for(const auto &entry : mEntries) {
+        total += entry.second.size;
+        order.push_back(std::make_pair(entry.second.lastUsed, entry.first));
+    }
+
+    // Remove the least recently used entries first
+    std::sort(order.begin(), order.end());
+
+    for(size_t i = 0; i < order.size() && total > mMaxSize; i++) {
+
+        const std::string &key = order[i].second;
+
+        total -= mEntries[key].size;
+
+        std::remove(entryPath(key).c_str());
+        mEntries.erase(key);
+    }
+}
+
+void BuildCache::loadManifest()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mEntries.clear();
+    mUseCounter = 0;
+
+    std::ifstream file(this->manifestPath());
+
+    if(!file.is_open())
+        return;
+
+    std::string line;
+
+    // Each line holds the key, size, last use and content hash of an entry, followed by the path of its source
+    while(std::getline(file, line)) {
+
+        std::istringstream str(line);
+
+        std::string entryKey;
+        Entry entry;
+
+        if(!(str >> entryKey))
+            continue;
+
+        // Entries of an earlier version of the manifest cannot be verified, so are removed
+        if(!(str >> entry.size >> entry.lastUsed >> std::hex >> entry.contentHash)) {
+            std::remove(entryPath(entryKey).c_str());
+            continue;
+        }
+
+        str >> std::ws;
+        std::getline(str, entry.source);
+
+        // Entries removed outside of the cache are discarded
+        if(!fs::path(entryPath(entryKey)).exists())
+            continue;
+
+        mEntries[entryKey] = entry;
+        mUseCounter = std::max(mUseCounter, entry.lastUsed);
+    }
+}
+
+void BuildCache::saveManifest() const
+{
+    const std::string path = this->manifestPath();
+    const std::string tmpPath = path + ".tmp";
+
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+
+        if(!file.is_open()) {
+            std::cerr << "Cache manifest '" << path << "' could not be written" << std::endl;
+            return;
+        }
+
+        for(const auto &entry : mEntries)
+            file << entry.first << " " << entry.second.size << " " << entry.second.lastUsed << " "
+                 << toHex(entry.second.contentHash) << " " << entry.second.source << "\n";
+    }
+
+    // Replace the manifest in a single step. Windows does not replace an existing file on rename.
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    std::rename(tmpPath.c_str(), path.c_str());
+}
@@ -0,0 +1,111 @@
+#ifndef SLM_BUILDCACHE_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_BUILDCACHE_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Header.h"
+#include "Reader.h"
+
+namespace slm
+{
+
+/**
+ * @brief The BuildCache class caches translated builds in the native libSLM format within a local directory.
+ *
+ * Builds are keyed by the size and modification time of the source file, a hash of sampled blocks of its contents
+ * (the head, the tail and blocks at a fixed stride) and the name of the format it is translated from, so a key is
+ * computed without reading the entire file. The full hash of the contents is only computed when storing an entry and
+ * when a different file matches the key of an entry, in which case the full hash decides whether it is a hit.
+ *
+ * When a build is opened which is present in the cache, the cached copy is opened with a NativeReader instead of
+ * translating the source file again. Otherwise the source file is parsed with the reader provided and the result is
+ * added to the cache. Entries are evicted in least-recently-used order once the total size of the cache exceeds its
+ * limit.
+ */
+class SLM_EXPORT BuildCache
+{
+public:
+    typedef std::shared_ptr<BuildCache> Ptr;
+
+    BuildCache(const std::string &cacheDir, uint64_t maxSize = 0);
+    ~BuildCache();
+
+public:
+    /**
+     * Opens the build with the file path of the reader. On a cache hit a parsed NativeReader of the cached build is
+     * returned, whose file path refers to the cache entry. Otherwise the reader is parsed, stored in the cache and
+     * returned.
+     * @param format The name and version of the format read by the reader, e.g. "mtt-1"
+     * @param header Header of the source build, stored with the cached build and returned by its NativeReader
+     * @return The parsed reader or a null pointer if the build could not be parsed
+     */
+    base::Reader::Ptr open(const base::Reader::Ptr &reader, const std::string &format, const Header &header);
+
+    /**
+     * As above, where the header is taken from the reader if it is a NativeReader. Other readers do not provide the
+     * header of their build, so the cached build records the source file name and a z unit of 0, which is unknown.
+     */
+    base::Reader::Ptr open(const base::Reader::Ptr &reader, const std::string &format);
+
+    // Returns the key of a source file in the cache, or an empty string if the file cannot be read
+    std::string key(const std::string &path, const std::string &format) const;
+
+    bool contains(const std::string &key) const;
+    bool remove(const std::string &key);
+    void clear();
+
+    const std::string & cacheDir() const { return mCacheDir; }
+    std::string entryPath(const std::string &key) const;
+
+    // Maximum total size of the cache entries in bytes, 0 is unlimited
+    void setMaxSize(uint64_t bytes);
+    uint64_t maxSize() const { return mMaxSize; }
+    uint64_t totalSize() const;
+    size_t numEntries() const;
+
+    // Fast non-cryptographic 64-bit hash of a region of memory
+    static uint64_t hash(const uint8_t *data, size_t len, uint64_t seed = 0);
+
+    // Hash of the entire contents of a file
+    static bool contentHash(const std::string &path, uint64_t &hash);
+
+    // Size of the blocks sampled from the head and tail of a file, and the number of blocks sampled in between
+    static const size_t SampleBlockSize = 65536;
+    static const size_t NumStridedBlocks = 16;
+
+protected:
+    struct Entry
+    {
+        uint64_t size;
+        uint64_t lastUsed;
+        uint64_t contentHash;  // Full hash of the source file
+        std::string source;    // Path of the source file
+    };
+
+    base::Reader::Ptr openEntry(const base::Reader::Ptr &reader, const std::string &format, const Header *header);
+    int store(const std::string &key, base::Reader &reader, uint64_t contentHash, const Header &header);
+    void touch(const std::string &key);
+    void evict();
+
+    void loadManifest();
+    void saveManifest() const;
+    std::string manifestPath() const;
+
+protected:
+    std::string mCacheDir;
+    uint64_t mMaxSize;
+    uint64_t mUseCounter;
+
+    std::map<std::string, Entry> mEntries;
+    mutable std::mutex mMutex;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_BUILDCACHE_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,92 @@
+#include "BuildStyleTable.h"
+
+using namespace slm;
+
+const uint32_t BuildStyleTable::InvalidIndex;
+
+BuildStyleParameters::BuildStyleParameters() : mid(0),
+                                               bid(0),
+                                               laserId(0),
+                                               laserMode(0),
+                                               laserPower(0.0),
+                                               laserFocus(0.0),
+                                               laserSpeed(0.0),
+                                               pointDistance(0),
+                                               pointDelay(0),
+                                               pointExposureTime(0),
+                                               jumpSpeed(0),
+                                               jumpDelay(0)
+{
+}
+
+BuildStyleParameters::BuildStyleParameters(uint64_t modelId, const BuildStyle &bstyle) : mid(modelId),
+                                                                                       bid(bstyle.id),
+                                                                                       laserId(bstyle.laserId),
+                                                                                       laserMode(bstyle.laserMode),
+                                                                                       laserPower(bstyle.laserPower),
+                                                                                       laserFocus(bstyle.laserFocus),
+                                                                                       laserSpeed(bstyle.laserSpeed),
+                                                                                       pointDistance(bstyle.pointDistance),
+                                                                                       pointDelay(bstyle.pointDelay),
+                                                                                       pointExposureTime(bstyle.pointExposureTime),
+                                                                                       jumpSpeed(bstyle.jumpSpeed),
+                                                                                       jumpDelay(bstyle.jumpDelay)
+{
+}
+
+BuildStyleTable::BuildStyleTable()
+{
+}
+
+BuildStyleTable::BuildStyleTable(const std::vector<Model::Ptr> &models)
+{
+    this->build(models);
+}
+
+BuildStyleTable::~BuildStyleTable()
+{
+}
+
+void BuildStyleTable::clear()
+{
+    mParameters.clear();
+    mIndex.clear();
+}
+
+void BuildStyleTable::build(const std::vector<Model::Ptr> &models)
+{
+    this->clear();
+
+    for(auto model : models) {
+
+        for(auto bstyle : model->getBuildStyles()) {
+
+            // The first build style of each id within a model is used, matching Model::getBuildStyleById
+            if(mIndex.emplace(key(model->getId(), bstyle->id), mParameters.size()).second)
+                mParameters.push_back(BuildStyleParameters(model->getId(), *bstyle));
+        }
+    }
+}
+
+uint32_t BuildStyleTable::indexOf(uint64_t mid, uint64_t bid) const
+{
+    auto it = mIndex.find(key(mid, bid));
+    return (it != mIndex.end()) ? it->second : InvalidIndex;
+}
+
+uint64_t BuildStyleTable::resolveLayer(const Layer &layer, ScanMode mode, std::vector<uint32_t> &styleIdx) const
+{
+    uint64_t numInvalid = 0;
+
+    for(auto geom : layer.geometryViews(mode)) {
+
+        const uint32_t idx = this->indexOf(geom.mid, geom.bid);
+
+        if(idx == InvalidIndex)
+            numInvalid++;
+
+        styleIdx.push_back(idx);
+    }
+
+    return numInvalid;
+}
@@ -0,0 +1,88 @@
+#ifndef SLM_BUILDSTYLETABLE_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_BUILDSTYLETABLE_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Layer.h"
+#include "Model.h"
+
+namespace slm
+{
+
+/**
+ * @brief The BuildStyleParameters struct holds the laser parameters of a BuildStyle used when processing geometry,
+ * without the names and descriptions, so that the parameters of all build styles are stored contiguously.
+ */
+struct SLM_EXPORT BuildStyleParameters
+{
+    BuildStyleParameters();
+    BuildStyleParameters(uint64_t modelId, const BuildStyle &bstyle);
+
+    uint64_t mid;
+    uint64_t bid;
+
+    uint64_t laserId;
+    uint64_t laserMode;
+
+    float    laserPower;
+    float    laserFocus;
+    float    laserSpeed;
+
+    uint64_t pointDistance;
+    uint64_t pointDelay;
+    uint64_t pointExposureTime;
+    uint64_t jumpSpeed;
+    uint64_t jumpDelay;
+};
+
+/**
+ * @brief The BuildStyleTable class resolves the model and build style ids of geometry to a dense index into a flat
+ * array of build style parameters. The table is built once from the models of a build, after which the build style
+ * of each geometry may be resolved in advance, so that processing the geometry requires a single array access rather
+ * than searching the models and their build styles.
+ */
+class SLM_EXPORT BuildStyleTable
+{
+public:
+    // Index of a geometry referencing a model or build style which does not exist
+    static const uint32_t InvalidIndex = UINT32_MAX;
+
+    BuildStyleTable();
+    explicit BuildStyleTable(const std::vector<Model::Ptr> &models);
+    ~BuildStyleTable();
+
+public:
+    void build(const std::vector<Model::Ptr> &models);
+    void clear();
+
+    uint32_t size() const { return mParameters.size(); }
+    bool empty() const { return mParameters.empty(); }
+
+    // Dense index of the build style or InvalidIndex
+    uint32_t indexOf(uint64_t mid, uint64_t bid) const;
+
+    const BuildStyleParameters & operator[](uint32_t idx) const { return mParameters[idx]; }
+    const BuildStyleParameters & at(uint32_t idx) const { return mParameters.at(idx); }
+    const std::vector<BuildStyleParameters> & parameters() const { return mParameters; }
+
+    /**
+     * Resolves the build style of each geometry of the layer, in the order given by the scan mode, appending the
+     * indices to styleIdx
+     * @return The number of geometries which could not be resolved
+     */
+    uint64_t resolveLayer(const Layer &layer, ScanMode mode, std::vector<uint32_t> &styleIdx) const;
+
+protected:
+    static uint64_t key(uint64_t mid, uint64_t bid) { return (mid << 32) | (bid & 0xFFFFFFFF); }
+
+    std::vector<BuildStyleParameters> mParameters;
+    std::unordered_map<uint64_t, uint32_t> mIndex;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_BUILDSTYLETABLE_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "NativeFormat.h"
+#include "NativeReader.h"
+#include "NativeWriter.h"
+
+#include "FormatRegistry.h"
+
+using namespace slm;
+
+const size_t FormatRegistry::SniffSize;
+
+bool FormatInfo::hasExtension(const std::string &ext) const
+{
+    return std::find(extensions.begin(), extensions.end(), ext) != extensions.end();
+}
+
+FormatRegistry::FormatRegistry()
+{
+}
+
+FormatRegistry::~FormatRegistry()
+{
+}
+
+FormatRegistry & FormatRegistry::instance()
+{
+    static FormatRegistry registry;
+    static std::once_flag nativeRegistered;
+
+    // The native format is always available
+    std::call_once(nativeRegistered, []() {
+
+        FormatInfo format;
+        format.name = "native";
+        format.extensions = {"slmn"};
+        format.sniff = [](const ByteSpan &head) {
+            return head.size >= sizeof(native::Magic) &&
+                   std::memcmp(head.data, native::Magic, sizeof(native::Magic)) == 0;
+        };
+        format.createReader = []() { return std::make_shared<NativeReader>(); };
+        format.createWriter = []() { return std::make_shared<NativeWriter>(); };
+
+        registry.registerFormat(format);
+    });
+
+    return registry;
+}
+
+std::string FormatRegistry::fileExtension(const std::string &path)
+{
+    const size_t sep = path.find_last_of("/\\");
+    const size_t dot = path.find_last_of('.');
+
+    if(dot == std::string::npos || (sep != std::string::npos && dot < sep))
+        return std::string();
+
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    return ext;
+}
+
+void FormatRegistry::registerFormat(const FormatInfo &format)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = std::find_if(mFormats.begin(), mFormats.end(), [&format](const FormatInfo &other) {
+        return other.name == format.name;
+    });
+
+    if(it != mFormats.end())
+        *it = format;
+    else
+        mFormats.push_back(format);
+}
+
+bool FormatRegistry::unregisterFormat(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = std::find_if(mFormats.begin(), mFormats.end(), [&name](const FormatInfo &format) {
+        return format.name == name;
+    });
+
+    if(it == mFormats.end())
+        return false;
+
+    mFormats.erase(it);
+
+    return true;
+}
+
+std::vector<std::string> FormatRegistry::formatNames() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::vector<std::string> names;
+
+    for(const FormatInfo &format : mFormats)
+        names.push_back(format.name);
+
+    return names;
+}
+
+bool FormatRegistry::findFormat(const std::string &name, FormatInfo &format) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for(const FormatInfo &other : mFormats) {
+        if(other.name == name) {
+            format = other;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FormatRegistry::detectFormat(const std::string &path, FormatInfo &format) const
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if(!file.is_open()) {
+        std::cerr << "File '" << path << "' could not be opened" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> buffer(SniffSize);
+    file.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+
+    const ByteSpan head(buffer.data(), static_cast<size_t>(file.gcount()));
+    const std::string ext = fileExtension(path);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const FormatInfo *sniffed = nullptr;
+
+    // A matching signature takes precedence, preferring a format which also matches the extension
+    for(const FormatInfo &other : mFormats) {
+
+        if(!other.sniff || !other.sniff(head))
+            continue;
+
+        if(!sniffed || (!sniffed->hasExtension(ext) && other.hasExtension(ext)))
+            sniffed = &other;
+    }
+
+    if(sniffed) {
+        format = *sniffed;
+        return true;
+    }
+
+    // Formats without a signature are identified by the extension alone
+    for(const FormatInfo &other : mFormats) {
+        if(!other.sniff && other.hasExtension(ext)) {
+            format = other;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+base::Reader::Ptr FormatRegistry::createReader(const std::string &path) const
+{
+    FormatInfo format;
+
+    if(!this->detectFormat(path, format) || !format.createReader) {
+        std::cerr << "File '" << path << "' is not of a known build format" << std::endl;
+        return base::Reader::Ptr();
+    }
+
+    base::Reader::Ptr reader = format.createReader();
+
+    if(reader)
+        reader->setFilePath(path);
+
+    return reader;
+}
+
+base::Writer::Ptr FormatRegistry::createWriter(const std::string &path, const std::string &formatName) const
+{
+    FormatInfo format;
+    bool found = false;
+
+    if(!formatName.empty()) {
+        found = this->findFormat(formatName, format);
+    } else {
+
+        const std::string ext = fileExtension(path);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for(const FormatInfo &other : mFormats) {
+            if(other.createWriter && other.hasExtension(ext)) {
+                format = other;
+                found = true;
+                break;
+            }
+        }
+    }
+
+    if(!found || !format.createWriter)
+        return base::Writer::Ptr();
+
+    base::Writer::Ptr writer = format.createWriter();
+
+    if(writer)
+        writer->setFilePath(path);
+
+    return writer;
+}
+
+base::Reader::Ptr slm::openBuild(const std::string &path)
+{
+    return FormatRegistry::instance().createReader(path);
+}
@@ -0,0 +1,100 @@
+#ifndef SLM_FORMATREGISTRY_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_FORMATREGISTRY_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Reader.h"
+#include "Writer.h"
+
+namespace slm
+{
+
+/**
+ * @brief The FormatInfo struct describes a build file format which may be registered with the FormatRegistry
+ */
+struct FormatInfo
+{
+    typedef std::function<bool(const ByteSpan &head)> Sniffer;
+    typedef std::function<base::Reader::Ptr()> ReaderFactory;
+    typedef std::function<base::Writer::Ptr()> WriterFactory;
+
+    std::string name;
+
+    // File extensions in lower case without the leading dot
+    std::vector<std::string> extensions;
+
+    // Checks the first bytes of a file for the signature of the format. Formats without a signature leave it empty.
+    Sniffer sniff;
+
+    ReaderFactory createReader;
+    WriterFactory createWriter;
+
+    bool hasExtension(const std::string &ext) const;
+};
+
+/**
+ * @brief The FormatRegistry class maps build file formats to their Reader and Writer. The format of a file is
+ * detected from its first bytes using the sniffer of each format, falling back to the file extension for formats
+ * without a signature, so no reader needs to attempt parsing the file. Translators register their formats with the
+ * shared instance, which includes the native libSLM format.
+ */
+class SLM_EXPORT FormatRegistry
+{
+public:
+    // Number of bytes at the start of a file passed to the sniffers
+    static const size_t SniffSize = 4096;
+
+    FormatRegistry();
+    ~FormatRegistry();
+
+public:
+    // Registers a format, replacing any format of the same name
+    void registerFormat(const FormatInfo &format);
+    bool unregisterFormat(const std::string &name);
+
+    std::vector<std::string> formatNames() const;
+    bool findFormat(const std::string &name, FormatInfo &format) const;
+
+    /**
+     * Detects the format of the file
+     * @return true if a format was found
+     */
+    bool detectFormat(const std::string &path, FormatInfo &format) const;
+
+    /**
+     * Creates the reader for the detected format of the file with its file path set. The build is not parsed.
+     * @return The reader or a null pointer if the format is unknown
+     */
+    base::Reader::Ptr createReader(const std::string &path) const;
+
+    /**
+     * Creates the writer for the format of the given name, or otherwise with an extension matching the file path
+     * @return The writer or a null pointer if the format is unknown or cannot be written
+     */
+    base::Writer::Ptr createWriter(const std::string &path, const std::string &formatName = std::string()) const;
+
+    // Shared registry used by openBuild
+    static FormatRegistry & instance();
+
+    static std::string fileExtension(const std::string &path);
+
+protected:
+    std::vector<FormatInfo> mFormats;
+    mutable std::mutex mMutex;
+};
+
+/**
+ * Opens a build using the reader of its detected format. The returned reader has not yet parsed the build.
+ * @return The reader or a null pointer if the format of the file is unknown
+ */
+SLM_EXPORT base::Reader::Ptr openBuild(const std::string &path);
+
+} // End of Namespace slm
+
+#endif // SLM_FORMATREGISTRY_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,203 @@
+#include <cassert>
+#include <algorithm>
+
+#include "Layer.h"
+#include "GeometryStore.h"
+
+using namespace slm;
+
+GeometryStore::GeometryStore(uint32_t dim) : mDim(dim),
+                                              mNumGeoms(0),
+                                              mNumPoints(0),
+                                              mExtCoords(nullptr),
+                                              mExtTypes(nullptr),
+                                              mExtModelIds(nullptr),
+                                              mExtBuildStyleIds(nullptr),
+                                              mExtOffsets(nullptr),
+                                              mExtLengths(nullptr)
+{
+}
+
+GeometryStore::~GeometryStore()
+{
+}
+
+void GeometryStore::clear()
+{
+    mCoords.clear();
+    mTypes.clear();
+    mModelIds.clear();
+    mBuildStyleIds.clear();
+    mOffsets.clear();
+    mLengths.clear();
+
+    mOwner.reset();
+    mNumGeoms = 0;
+    mNumPoints = 0;
+}
+
+void GeometryStore::reserve(size_t numGeoms, uint64_t numPoints)
+{
+    mCoords.reserve(numPoints * mDim);
+    mTypes.reserve(numGeoms);
+    mModelIds.reserve(numGeoms);
+    mBuildStyleIds.reserve(numGeoms);
+    mOffsets.reserve(numGeoms);
+    mLengths.reserve(numGeoms);
+}
+
+int64_t GeometryStore::append(LayerGeometry::TYPE type, uint32_t mid, uint32_t bid, const float *coords, uint64_t numPoints)
+{
+    // Externally held arrays cannot be extended
+    if(mOwner)
+        return -1;
+
+    mTypes.push_back(static_cast<uint8_t>(type));
+    mModelIds.push_back(mid);
+    mBuildStyleIds.push_back(bid);
+    mOffsets.push_back(mCoords.size());
+    mLengths.push_back(numPoints);
+
+    if(numPoints > 0)
+        mCoords.insert(mCoords.end(), coords, coords + numPoints * mDim);
+
+    return mTypes.size() - 1;
+}
+
+int64_t GeometryStore::append(const LayerGeometry &geom)
+{
+    if(geom.coords.size() > 0 && geom.coords.cols() != mDim)
+        return -1;
+
+    return append(geom.getType(), geom.mid, geom.bid, geom.coords.data(), geom.coords.rows());
+}
+
+int64_t GeometryStore::append(const GeometryView &view)
+{
+    if(view.rows > 0 && view.cols != mDim)
+        return -1;
+
+    return append(view.type, view.mid, view.bid, view.data, view.rows);
+}
+
+GeometryView GeometryStore::at(size_t idx) const
+{
+    assert(idx < size());
+
+    return GeometryView(static_cast<LayerGeometry::TYPE>(typeData()[idx]),
+                        modelIdData()[idx],
+                        buildStyleIdData()[idx],
+                        coordData() + offsetData()[idx],
+                        lengthData()[idx],
+                        mDim);
+}
+
+LayerGeometry::Ptr GeometryStore::createGeometry(size_t idx) const
+{
+    const GeometryView view = at(idx);
+
+    LayerGeometry::Ptr geom;
+
+    switch(view.type) {
+        case LayerGeometry::HATCH:
+            geom = std::make_shared<HatchGeometry>(view.mid, view.bid); break;
+        case LayerGeometry::POLYGON:
+            geom = std::make_shared<ContourGeometry>(view.mid, view.bid); break;
+        case LayerGeometry::PNTS:
+            geom = std::make_shared<PntsGeometry>(view.mid, view.bid); break;
+        default:
+            geom = std::make_shared<LayerGeometry>(view.mid, view.bid); break;
+    }
+
+    geom->coords = view.coords();
+
+    return geom;
+}
+
+GeometryStore::Ptr GeometryStore::fromGeometry(const std::vector<LayerGeometry::Ptr> &geoms)
+{
+    const uint32_t dim = 2;
+    uint64_t numPoints = 0;
+
+    for(auto geom : geoms) {
+        if(geom->coords.size() > 0 && geom->coords.cols() != dim)
+            return GeometryStore::Ptr(); // Only geometry of a uniform dimension may be stored
+
+        numPoints += geom->coords.rows();
+    }
+
+    GeometryStore::Ptr store = std::make_shared<GeometryStore>(dim);
+    store->reserve(geoms.size(), numPoints);
+
+    for(auto geom : geoms)
+        store->append(*geom);
+
+    return store;
+}
+
+GeometryStore::Ptr GeometryStore::compactLayers(const std::vector<Layer::Ptr> &layers)
+{
+    const uint32_t dim = 2;
+    size_t numGeoms = 0;
+    uint64_t numPoints = 0;
+
+    for(auto layer : layers) {
+        for(auto geom : layer->geometryViews()) {
+            if(geom.rows > 0 && geom.cols != dim)
+                return GeometryStore::Ptr(); // Only geometry of a uniform dimension may be stored
+
+            numPoints += geom.rows;
+            numGeoms++;
+        }
+    }
+
+    GeometryStore::Ptr store = std::make_shared<GeometryStore>(dim);
+    store->reserve(numGeoms, numPoints);
+
+    for(auto layer : layers) {
+
+        const size_t first = store->size();
+
+        for(auto geom : layer->geometryViews())
+            store->append(geom);
+
+        layer->setGeometryStore(store, first, store->size() - first);
+    }
+
+    return store;
+}
+
+GeometryStore::Ptr GeometryStore::wrap(std::shared_ptr<const void> owner,
+                                       uint32_t dim,
+                                       size_t numGeoms,
+                                       uint64_t numPoints,
+                                       const float *coords,
+                                       const uint8_t *types,
+                                       const uint32_t *mids,
+                                       const uint32_t *bids,
+                                       const uint64_t *offsets,
+                                       const uint64_t *lengths)
+{
+    if(!owner || dim == 0)
+        return GeometryStore::Ptr();
+
+    // Every block must lie within the coordinate array
+    for(size_t i = 0; i < numGeoms; i++) {
+        if(offsets[i] > numPoints * dim || lengths[i] * dim > numPoints * dim - offsets[i])
+            return GeometryStore::Ptr();
+    }
+
+    GeometryStore::Ptr store = std::make_shared<GeometryStore>(dim);
+
+    store->mOwner = owner;
+    store->mNumGeoms = numGeoms;
+    store->mNumPoints = numPoints;
+    store->mExtCoords = coords;
+    store->mExtTypes = types;
+    store->mExtModelIds = mids;
+    store->mExtBuildStyleIds = bids;
+    store->mExtOffsets = offsets;
+    store->mExtLengths = lengths;
+
+    return store;
+}
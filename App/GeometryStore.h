@@ -0,0 +1,122 @@
+#ifndef SLM_GEOMETRYSTORE_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_GEOMETRYSTORE_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "Layer.h"
+
+namespace slm
+{
+
+/**
+ * @brief The GeometryStore class keeps the geometry of one or more layers in a contiguous structure-of-arrays layout.
+ *
+ * Coordinates of every geometry block are packed into a single float buffer, stored column-major per block
+ * (identical to the layout of LayerGeometry::coords), with parallel arrays for the type, model id, build style id,
+ * offset and length of each block. Individual blocks are accessed as a GeometryView, which maps straight onto the
+ * buffer, so no LayerGeometry object needs to be allocated per block.
+ *
+ * A store may alternatively reference arrays held externally, e.g. within a memory mapped file, using wrap(). Such a
+ * store is read-only and retains the owner of the arrays for as long as the store exists.
+ */
+class SLM_EXPORT GeometryStore
+{
+public:
+
+    typedef std::shared_ptr<GeometryStore> Ptr;
+
+    GeometryStore(uint32_t dim = 2);
+    ~GeometryStore();
+
+public:
+
+    void clear();
+    void reserve(size_t numGeoms, uint64_t numPoints);
+
+    /**
+     * Appends a geometry block and returns its index within the store or -1 if the dimensions do not match
+     * @param coords - column-major coordinates with numPoints rows and dimension() columns
+     */
+    int64_t append(LayerGeometry::TYPE type, uint32_t mid, uint32_t bid, const float *coords, uint64_t numPoints);
+    int64_t append(const LayerGeometry &geom);
+    int64_t append(const GeometryView &view);
+
+    /**
+     * Getters
+     */
+    size_t size() const { return mOwner ? mNumGeoms : mTypes.size(); }
+    bool empty() const { return size() == 0; }
+    uint32_t dimension() const { return mDim; }
+    uint64_t numPoints() const { return mOwner ? mNumPoints : mCoords.size() / mDim; }
+    bool isExternal() const { return static_cast<bool>(mOwner); }
+
+    GeometryView at(size_t idx) const;
+    LayerGeometry::Ptr createGeometry(size_t idx) const;
+
+    /*
+     * Raw access to the parallel arrays
+     */
+    const float    * coordData() const { return mOwner ? mExtCoords : mCoords.data(); }
+    const uint8_t  * typeData() const { return mOwner ? mExtTypes : mTypes.data(); }
+    const uint32_t * modelIdData() const { return mOwner ? mExtModelIds : mModelIds.data(); }
+    const uint32_t * buildStyleIdData() const { return mOwner ? mExtBuildStyleIds : mBuildStyleIds.data(); }
+    const uint64_t * offsetData() const { return mOwner ? mExtOffsets : mOffsets.data(); }
+    const uint64_t * lengthData() const { return mOwner ? mExtLengths : mLengths.data(); }
+
+public:
+    /**
+     * Packs a list of geometry into a new store. Returns a null pointer if the geometry is not two-dimensional.
+     */
+    static GeometryStore::Ptr fromGeometry(const std::vector<LayerGeometry::Ptr> &geoms);
+
+    /**
+     * Packs the geometry of all layers into a single store shared across the build. Each layer is assigned its
+     * own range within the store and its individual LayerGeometry objects are released. The layers are left
+     * unchanged and a null pointer is returned if the geometry is not two-dimensional.
+     */
+    static GeometryStore::Ptr compactLayers(const std::vector<Layer::Ptr> &layers);
+
+    /**
+     * Creates a read-only store referencing externally held arrays without copying them. The owner is retained by
+     * the store so that the arrays remain valid. The offsets index into coords in units of floats.
+     */
+    static GeometryStore::Ptr wrap(std::shared_ptr<const void> owner,
+                                   uint32_t dim,
+                                   size_t numGeoms,
+                                   uint64_t numPoints,
+                                   const float *coords,
+                                   const uint8_t *types,
+                                   const uint32_t *mids,
+                                   const uint32_t *bids,
+                                   const uint64_t *offsets,
+                                   const uint64_t *lengths);
+
+protected:
+    uint32_t mDim;
+
+    std::vector<float>    mCoords;
+    std::vector<uint8_t>  mTypes;
+    std::vector<uint32_t> mModelIds;
+    std::vector<uint32_t> mBuildStyleIds;
+    std::vector<uint64_t> mOffsets; // Offset of each block into mCoords
+    std::vector<uint64_t> mLengths; // Number of points in each block
+
+    // Arrays referenced by an external store
+    std::shared_ptr<const void> mOwner;
+    size_t   mNumGeoms;
+    uint64_t mNumPoints;
+    const float    *mExtCoords;
+    const uint8_t  *mExtTypes;
+    const uint32_t *mExtModelIds;
+    const uint32_t *mExtBuildStyleIds;
+    const uint64_t *mExtOffsets;
+    const uint64_t *mExtLengths;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_GEOMETRYSTORE_H_HEADER_HAS_BEEN_INCLUDED
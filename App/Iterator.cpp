@@ -1,7 +1,5 @@
 #include <assert.h>
 
-#include <Base/Tree.h>
-
 #include "Layer.h"
 #include "Model.h"
 #include "Slm.h"
@@ -10,10 +8,20 @@
 
 using namespace slm;
 
-Iterator::Iterator(Slm *val) : _inc(0),
-                               _layerInc(0),
-                               _layerGeomInc(0),
-                               obj(val)
+Iterator::Iterator() : obj(nullptr),
+                       _inc(0),
+                       _endTime(0),
+                       _timeInc(1e-3),
+                       _layerInc(0),
+                       _layerGeomInc(0)
+{
+}
+
+Iterator::Iterator(const Slm *val) : obj(val),
+                                     _inc(0),
+                                     _timeInc(1e-3),
+                                     _layerInc(0),
+                                     _layerGeomInc(0)
 {
     this->_endTime = this->obj->getBuildTime();
 }
@@ -44,9 +52,9 @@ int Iterator::getCurrentLayerNumber() const
 
 Layer::Ptr Iterator::getCurrentLayer() const
 {
-    assert(this->_layerInc < this->obj->layers.length());
+    assert(this->_layerInc >= 0 && this->_layerInc < static_cast<int>(this->obj->layers.size()));
 
-    return this->obj->layers.at(this->_layerInc);
+    return this->obj->layers[this->_layerInc];
 }
 
 void  Iterator::seek(const double &time)
@@ -68,36 +76,40 @@ bool Iterator::more() const
 
 State Iterator::value() const
 {
-    if(this->_inc > this->_endTime) {
-        State state;
+    State state;
+    state.laserOn = false;
+    state.power = 0.0f;
+    state.pntExposureTime = 0;
+    state.pntDistance = 0;
+    state.position.setZero();
+    state.velocity.setZero();
+    state.time  = this->_inc;
+    state.layer = this->_layerInc;
+
+    if(this->_inc > this->_endTime)
         return state;
-    }
 
-    State state;
-    state.time   = this->_inc;
-    state.layer  = this->_layerInc;
-
-    double z;
-
-    this->obj->getLaserPosition(this->_inc,
-                                state.position.rx(),
-                                state.position.ry(),
-                                z,
-                                state.laserOn);
-
-    this->obj->getLaserVelocity(this->_inc,
-                                state.velocity.rx(),
-                                state.velocity.ry(),
-                                state.laserOn);
-
-    this->obj->getLaserParameters(this->_inc,
-                                  state.power,
-                                  state.pntExposureTime,
-                                  state.pntDistance,
-                                  state.laserOn);
+    // A single sample is located directly, as one step of the sweep used by Slm::sampleLaserState
+    Slm::SweepCursor cursor;
+    Slm::LaserSample sample;
+    this->obj->sweepSample(this->_inc, cursor, sample);
+
+    state.laserOn = sample.laserOn;
+    state.power   = sample.power;
+    state.pntExposureTime = sample.exposureTime;
+    state.pntDistance = sample.pointDistance;
+    state.position = sample.position.head<2>().cast<float>();
+    state.velocity = sample.velocity.cast<float>();
+    state.layer = sample.layer;
+
     return state;
 }
 
+void Iterator::sample(uint64_t n, LaserStateSeries &series) const
+{
+    this->obj->sampleLaserState(this->_inc, this->_timeInc, n, series);
+}
+
 void Iterator::next()
 {
     if(this->_inc > this->_endTime)
@@ -106,11 +118,11 @@ void Iterator::next()
         this->_inc += this->_timeInc;
 }
 
-LayerIterator::LayerIterator(Slm *val, int layerId) : Iterator(val)
+LayerIterator::LayerIterator(const Slm *val, int layerId) : Iterator(val)
 {
-    this->_layerInc = layerId;
-    node n = this->obj->getTimeIndex().getValue(layerId);
-    this->_endTime = n.getNodeValue();
+    // Iterate across the laser scan of the layer
+    this->seekLayer(layerId);
+    this->_endTime = this->_inc + this->obj->getLayerScanTime(layerId);
 }
 
 LayerIterator::~LayerIterator()
@@ -118,14 +130,10 @@ LayerIterator::~LayerIterator()
 
 }
 
-LayerGeomIterator::LayerGeomIterator(Slm *val) : Iterator(val)
+LayerGeomIterator::LayerGeomIterator(const Slm *val) : Iterator(val),
+                                                       _geomIdx(0)
 {
-    this->_layerInc   = 0;
-    this->_layerGeomInc = 0;
-    this->_layerCache = this->obj->getLayers();
-    this->_layerIt    = this->_layerCache.cbegin();
-    this->_layerGeomCache = (*_layerIt)->getGeometry(this->obj->getScanMode());
-    this->_layerGeomIt = this->_layerGeomCache.cbegin();
+    this->updateLayer();
 }
 
 LayerGeomIterator::~LayerGeomIterator()
@@ -148,6 +156,31 @@ LayerGeomIterator LayerGeomIterator::operator++(int)
    return temp;
 }
 
+void LayerGeomIterator::updateLayer()
+{
+    const std::vector<uint64_t> &offsets = this->obj->layerGeomOffsets;
+    const int numLayers = static_cast<int>(this->obj->layers.size());
+
+    // Skip layers ending at or before the current geometry, including layers without geometry
+    while(this->_layerInc < numLayers && this->_geomIdx >= offsets[this->_layerInc + 1])
+        this->_layerInc++;
+
+    this->_layerGeomInc = (this->_layerInc < numLayers) ? this->_geomIdx - offsets[this->_layerInc] : 0;
+
+    this->updateViews();
+}
+
+void LayerGeomIterator::updateViews()
+{
+    if(!this->valid()) {
+        this->_views = GeometryViewRange();
+        return;
+    }
+
+    if(this->_views.layer() != this->obj->layers[this->_layerInc].get())
+        this->_views = this->obj->layerViews(this->_layerInc);
+}
+
 double LayerGeomIterator::getCurrentTime() const
 {
     return this->obj->getTimeByLayerGeomId(this->_layerInc, this->_layerGeomInc);
@@ -158,149 +191,200 @@ int LayerGeomIterator::getCurrentLayerNumber() const
     return this->_layerInc;
 }
 
+int LayerGeomIterator::getCurrentLayerGeomNumber() const
+{
+    return this->_layerGeomInc;
+}
+
 Layer::Ptr LayerGeomIterator::getCurrentLayer() const
 {
-    return *this->_layerIt;
+    if(this->_layerInc < 0 || this->_layerInc >= static_cast<int>(this->obj->layers.size()))
+        return Layer::Ptr();
+
+    return this->obj->layers[this->_layerInc];
 }
 
 void LayerGeomIterator::seek(const double &time)
 {
-    this->_inc = time;
-    int layerNum = this->obj->getLayerIdByTime(time);
+    int layerId, geomId;
 
-    if(layerNum < 0) {
+    if(!this->obj->getGeomIdByTime(time, layerId, geomId))
         return; // Invalid time provided to seek too
-    }
-
-    LayerGeometry *lgeom = this->obj->getLayerGeometryByTime(time);
-    if(!lgeom){
-        return; // invalid time provided
-    }
-
-    this->seekLayer(layerNum);
-    this->_layerGeomCache = (*this->_layerIt)->getGeometry(this->obj->getScanMode());
-    this->_layerGeomIt = this->_layerGeomCache.cbegin();
-
-    bool found = false;
-
-    // Reverse foconstBeginr loop so iterator is at beginning of the layer
-    for(; this->_layerGeomIt != this->_layerGeomCache.begin(); this->_layerGeomIt++, this->_layerGeomInc) {
-
-        // Check if geom found matches rather than parsing the tree
-        if(*this->_layerGeomIt == lgeom) {
-            found = true;
-            break;
-        }
-    }
-
-    if(!found) {
-        qWarning() << "Layer Geometry not found during seek";
-    }
 
+    this->_inc = time;
+    this->_layerInc = layerId;
+    this->_layerGeomInc = geomId;
+    this->_geomIdx = this->obj->geomIndex(layerId, geomId);
+    this->updateViews();
 }
 
 void  LayerGeomIterator::seekLayer(const int &layerNum)
 {
-    this->_layerIt = this->obj->getLayers().begin();
-    this->_layerIt += layerNum;
+    if(layerNum < 0 || layerNum >= static_cast<int>(this->obj->layers.size()))
+        return;
 
+    this->_inc = this->obj->getTimeByLayerId(layerNum);
     this->_layerInc = layerNum;
+    this->_geomIdx = this->obj->layerGeomOffsets[layerNum];
+    this->updateLayer();
+}
+
+bool LayerGeomIterator::valid() const
+{
+    return this->_geomIdx < this->obj->geomTimes.size();
 }
 
 bool LayerGeomIterator::more() const
 {
-    if(this->_layerIt +1 != this->_layerCache.constEnd()) {
-        return true; // More layers exist
-    } else if(this->_layerGeomIt + 1 != this->_layerGeomCache.constEnd()) {
-        return true; // More layer geoms exist on current layer
-    }
-    return false;
+    return this->_geomIdx + 1 < this->obj->geomTimes.size();
 }
 
 void LayerGeomIterator::next()
 {
-    // Get the current layer
-    Layer::Ptr layer = *this->_layerIt;
-
-    this->_layerGeomInc++;
+    if(!this->valid())
+        return;
 
-    if(++(this->_layerGeomIt) == this->_layerGeomCache.constEnd()) {
-        this->_layerIt++; // Iterate to the next layer
-        this->_layerInc++;
-        this->_layerGeomCache.clear(); // Invalidate cache
-    }
+    this->_geomIdx++;
+    this->updateLayer();
+}
 
-    // Check cache
-    if(_layerGeomCache.empty()) {
+LayerGeometry::Ptr LayerGeomIterator::getLayerGeometry() const
+{
+    return this->value();
+}
 
-        if(this->_layerIt != this->_layerCache.constEnd()) {
-            this->_layerGeomCache = (*_layerIt)->getGeometry(this->obj->getScanMode());
+GeometryView LayerGeomIterator::getGeometryView() const
+{
+    assert(this->valid());
 
-            // Reset geometry iterators
-            this->_layerGeomIt = this->_layerGeomCache.constBegin();
-            this->_layerGeomInc = 0;
-        }
-    }
+    return this->_views.at(this->_layerGeomInc);
 }
 
-LayerGeometry * LayerGeomIterator::getLayerGeometry() const
+LayerGeometry::Ptr LayerGeomIterator::value() const
 {
-    return this->value();
+    if(!this->valid())
+        return LayerGeometry::Ptr();
+
+    const Layer::Ptr &layer = this->obj->layers[this->_layerInc];
+
+    return layer->geometryAt(layer->geometryOrder(this->obj->getScanMode())[this->_layerGeomInc]);
 }
 
-LayerGeometry * LayerGeomIterator::value() const
+
+LaserScanIterator::LaserScanIterator(const Slm *val) : LayerGeomIterator(val),
+                                                       _scanInc(0)
 {
-    return *this->_layerGeomIt;
+    this->loadGeometry();
+
+    // Begin at the first geometry with a laser scan
+    while(this->valid() && numScans(this->_curGeom) == 0) {
+        LayerGeomIterator::next();
+        this->loadGeometry();
+    }
 }
 
+LaserScanIterator::~LaserScanIterator()
+{
+
+}
 
-LaserScanIterator::LaserScanIterator(Slm *val) : LayerGeomIterator(val)
+uint64_t LaserScanIterator::numScans(const GeometryView &geom)
 {
-    this->_curLayerGeom = LayerGeomIterator::value();
-    this->_pntIt = this->_curLayerGeom->coords.cbegin();
+    if(geom.cols < 2)
+        return 0;
+
+    switch(geom.type) {
+        case LayerGeometry::HATCH:
+            return geom.rows / 2;
+        case LayerGeometry::POLYGON:
+            return geom.rows > 1 ? geom.rows - 1 : 0;
+        default:
+            return geom.rows;
+    }
 }
 
-LaserScanIterator::~LaserScanIterator()
+void LaserScanIterator::loadGeometry()
 {
+    this->_scanInc = 0;
+
+    if(!this->valid()) {
+        this->_curGeom = GeometryView();
+        this->_curGeom.rows = 0;
+        this->_curGeom.cols = 0;
+        this->_curTable.reset();
+        return;
+    }
 
+    this->_curGeom  = this->getGeometryView();
+    this->_curTable = this->obj->getArcLengthTable(this->_layerInc, this->_layerGeomInc);
 }
 
 bool LaserScanIterator::more() const
 {
-    if(LayerGeomIterator::more()) {
+    if(this->_scanInc + 1 < numScans(this->_curGeom))
         return true;
-    } else {
-
-        if(this->_curLayerGeom->getType() == LayerGeometry::HATCH) {
-            return this->_pntIt + 2 != this->_curLayerGeom->coords.cend();
-        } else if(this->_curLayerGeom->getType() == LayerGeometry::POLYGON) {
-            return this->_pntIt + 1 != this->_curLayerGeom->coords.cend();
-        } else {
-            return this->_pntIt + 1 != this->_curLayerGeom->coords.cend();
-        }
+
+    // Find a following geometry with a laser scan
+    const std::vector<uint64_t> &offsets = this->obj->layerGeomOffsets;
+    int layerId = this->_layerInc;
+    GeometryViewRange views = this->_views;
+
+    for(uint64_t k = this->_geomIdx + 1; k < this->obj->geomTimes.size(); k++) {
+
+        while(k >= offsets[layerId + 1])
+            layerId++;
+
+        if(views.layer() != this->obj->layers[layerId].get())
+            views = this->obj->layerViews(layerId);
+
+        if(numScans(views.at(k - offsets[layerId])) > 0)
+            return true;
     }
+
+    return false;
 }
 
+double LaserScanIterator::calcScanTime(double dist) const
+{
+    const BuildStyleParameters *bstyle = this->obj->getBuildStyle(this->_layerInc, this->_layerGeomInc);
+
+    if(!bstyle || bstyle->laserSpeed <= 0.0)
+        return 0.0;
+
+    return dist / bstyle->laserSpeed;
+}
 
 LaserScan LaserScanIterator::value() const
 {
+    const GeometryView &geom = this->_curGeom;
+
     LaserScan scan;
-    scan.type   = this->_curLayerGeom->getType();
+    scan.type   = geom.type;
     scan.layer  = this->_layerInc;
-    scan.tStart = this->getCurrentTime();
-    scan.tEnd   = this->getCurrentTime() + this->calcScanTime();
-
-    if(scan.type == LayerGeometry::HATCH) {
-        scan.start = *(this->_pntIt); // Return value
-        scan.end   = *(this->_pntIt + 1);
-    } else if(scan.type == LayerGeometry::POLYGON) {
-        scan.start = *(this->_pntIt ); // Return value
-        scan.end   = *(this->_pntIt+1);
-    } else {
-        scan.start = *(this->_pntIt); // Return value
-        scan.end = scan.start;
+    scan.mid    = geom.mid;
+    scan.bid    = geom.bid;
+    scan.tStart = LayerGeomIterator::getCurrentTime();
+    scan.tEnd   = scan.tStart;
+    scan.start.setZero();
+    scan.end.setZero();
+
+    if(this->_scanInc >= numScans(geom))
+        return scan;
+
+    uint64_t row1 = this->_scanInc;
+    uint64_t row2 = this->_scanInc;
+
+    if(this->_curTable && this->_curTable->numSegments() > 0) {
+        row1 = this->_curTable->segmentFirstRow(this->_scanInc);
+        row2 = this->_curTable->segmentLastRow(this->_scanInc);
+
+        scan.tEnd   = scan.tStart + this->calcScanTime(this->_curTable->segmentStart(this->_scanInc + 1));
+        scan.tStart = scan.tStart + this->calcScanTime(this->_curTable->segmentStart(this->_scanInc));
     }
 
+    scan.start = Eigen::Vector2f(geom.data[row1], geom.data[geom.rows + row1]);
+    scan.end   = Eigen::Vector2f(geom.data[row2], geom.data[geom.rows + row2]);
+
     return scan;
 }
 
@@ -318,68 +402,20 @@ LaserScanIterator LaserScanIterator::operator++(int)
    ++*this;
    return temp;
 }
+
 double LaserScanIterator::getCurrentTime() const
 {
-    return this->_layerGeomTime + this->_relTime;
-}
-
- // Calculates the current scan time of the iterator
-double LaserScanIterator::calcScanTime() const
-{
-    double scanTime;
-
-    // Get Laser Parameters
-    LayerGeometry *geom = this->getLayerGeometry();
-    Model *model = this->obj->getModelById(geom->mid);
-    BuildStyle *bstyle = model->getBuildStyleById(geom->bid);
-
-    switch(geom->getType()) {
-        case LayerGeometry::HATCH:
-        case LayerGeometry::POLYGON: {
-           QPointF start, end;
-
-            start = *(this->_pntIt); // Return value
-            end   = *(this->_pntIt + 1);
-
-            QPointF delta = end-start;
-            double dist = sqrt(pow(delta.x(),2) + pow(delta.y(),2));
-            scanTime = dist / bstyle->laserSpeed;
-        } break;
-        default:
-            scanTime = bstyle->pointExposureTime; break;
-    }
-    return scanTime;
+    return this->value().tStart;
 }
 
 void LaserScanIterator::next()
 {
+    if(++this->_scanInc < numScans(this->_curGeom))
+        return;
 
-    bool newLayerGeom = false;
-
-    // Add on previous laser scan time
-    this->_relTime += this->calcScanTime();
-
-    if(this->_curLayerGeom->getType() == LayerGeometry::HATCH) {
-        this->_pntIt++; // Advance once since coords are in pairs
-        this->_pntIt++;
-        newLayerGeom = this->_pntIt == this->_curLayerGeom->coords.cend();
-    } else if(this->_curLayerGeom->getType() == LayerGeometry::POLYGON) {
-        this->_pntIt++;
-        newLayerGeom = this->_pntIt == this->_curLayerGeom->coords.cend() - 1;
-    } else {
-        this->_pntIt++;
-        newLayerGeom = this->_pntIt == this->_curLayerGeom->coords.cend();
-    }
-
-    if(newLayerGeom) {
-        // Clear the previous layerGeometry
-        if(LayerGeomIterator::more()) {
-            LayerGeomIterator::next(); // Iterate to the next LayerGeometry
-
-            this->_relTime = 0; // Reset relative time for current layer geometry
-            this->_curLayerGeom = LayerGeomIterator::value();
-            this->_pntIt = this->_curLayerGeom->coords.cbegin();
-            this->_layerGeomTime = LayerGeomIterator::getCurrentTime();
-        }
-    }
+    // Iterate to the next LayerGeometry with a laser scan
+    do {
+        LayerGeomIterator::next();
+        this->loadGeometry();
+    } while(this->valid() && numScans(this->_curGeom) == 0);
 }
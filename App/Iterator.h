@@ -3,16 +3,17 @@
 
 #include "SLM_Export.h"
 
+#include <cstdint>
+
 #include <Eigen/Dense>
 
+#include "ArcLengthTable.h"
 #include "Layer.h"
 #include "Slm.h"
 
 namespace slm
 {
 
-class Layer;
-
 // Current state of laser power at time t
 struct State
 {
@@ -20,32 +21,26 @@ struct State
     float   power;            // Laser Power (W)
     int     pntExposureTime;  // Point Exposure Time (ms)
     int     pntDistance;      // Point Distance (microm)
-    inline float   laserSpeed() { return (float) pntDistance * 1. / (float) pntExposureTime; }
+    inline float   laserSpeed() const { return (float) pntDistance * 1. / (float) pntExposureTime; }
     Eigen::Vector2f position;         // s = (x,y)'
     Eigen::Vector2f velocity;         // v = (u,v)' // Note w is zero
-    uint    layer;
+    int     layer;
     double  time;                // Current time
 };
 
-struct LaserScan
-{
-    Eigen::Vector2f  start;
-    Eigen::Vector2f  end;
-    double  tStart;
-    double  tEnd;
-    uint    layer;
-    LayerGeometry::TYPE type;
-};
-
+/**
+ * @brief The Iterator class steps through the build of a Slm at a fixed time increment. The Slm must outlive the
+ * iterator.
+ */
 class SLM_EXPORT Iterator
 {
 public:
-    typedef Slm::node node;
-    Iterator(Slm *val);
+    Iterator(const Slm *val);
     Iterator();
     ~Iterator();
 
     void setTimeIncrement(double val) { _timeInc = val; }
+    double getTimeIncrement() const { return _timeInc; }
 
 public:
     void  seek(const double &time);
@@ -58,13 +53,15 @@ public:
     void  next();
     State value() const;
 
+    // Samples the state of the laser at the current and following n - 1 increments in a single sweep of the build
+    void sample(uint64_t n, LaserStateSeries &series) const;
+
+    double getCurrentTime() const { return _inc; }
     int getCurrentLayerNumber() const;
     Layer::Ptr getCurrentLayer() const;
 
-    // Add operator ++ to increment automtically
-
 protected:
-    Slm::Ptr obj; // TODO make a smart pointer
+    const Slm *obj;
     double _inc;       // Current increment
     double _endTime;
     double _timeInc;   // The finite time difference to iterate with
@@ -76,24 +73,25 @@ protected:
 class SLM_EXPORT LayerIterator: public Iterator
 {
 public:
-    LayerIterator(Slm *val, int layerId);
+    LayerIterator(const Slm *val, int layerId);
     ~LayerIterator();
-
-private:
-    double _layerTime;
 };
 
-
+/**
+ * @brief The LayerGeomIterator class steps through the geometry of the build in the order it is scanned. Layers
+ * without geometry are skipped.
+ */
 class SLM_EXPORT LayerGeomIterator : public Iterator
 {
 public:
-    LayerGeomIterator(Slm::Ptr val);
+    LayerGeomIterator(const Slm *val);
     ~LayerGeomIterator();
 
 public:
     void seek(const double &time);
     void seekLayer(const int &layerNum);
     int getCurrentLayerNumber() const;
+    int getCurrentLayerGeomNumber() const;
     Layer::Ptr getCurrentLayer() const;
 
     double getCurrentTime() const;
@@ -101,23 +99,35 @@ public:
     LayerGeomIterator& operator++();       // Prefix increment operator.
     LayerGeomIterator operator++(int);     // Postfix increment operator.
 
-    LayerGeometry getLayerGeometry() const;
+    LayerGeometry::Ptr getLayerGeometry() const;
+
+    // The view remains valid whilst the iterator is positioned on the same layer
+    GeometryView getGeometryView() const;
+
+    // Returns true if the iterator is positioned on a geometry
+    bool valid() const;
 
     bool more() const;
     void next();
-    LayerGeometry value() const;
+    LayerGeometry::Ptr value() const;
 
-private:
-    std::vector<Layer::Ptr>::const_iterator _layerIt; // Current Layer Iterator
-    std::vector<LayerGeometry::Ptr> _layerGeomCache;
-    std::vector<Layer::Ptr> _layerCache;
-    std::vector<LayerGeometry>::const_iterator _layerGeomIt; // Current Layer Geometry Iterator
+protected:
+    // Moves to the layer containing the current geometry
+    void updateLayer();
+    void updateViews();
+
+    uint64_t _geomIdx;        // Index of the geometry within the Slm time index
+    GeometryViewRange _views; // Geometry of the current layer, which pins the layer
 };
 
+/**
+ * @brief The LaserScanIterator class steps through the individual scan vectors of the build in the order they are
+ * scanned. Each point of point geometry is returned as a scan with the same start and end.
+ */
 class SLM_EXPORT LaserScanIterator : public LayerGeomIterator
 {
 public:
-    LaserScanIterator(Slm *val);
+    LaserScanIterator(const Slm *val);
     ~LaserScanIterator();
 
 public:
@@ -131,14 +141,17 @@ public:
     bool more() const;
     LaserScan value() const;
 
+    // Number of laser scans of the geometry
+    static uint64_t numScans(const GeometryView &geom);
+
 private:
-    double calcScanTime() const;
-    double _layerGeomTime,
-           _relTime; // Relative time
+    void loadGeometry();
+    double calcScanTime(double dist) const;
 
-    LayerGeometry _curLayerGeom;
+    uint64_t _scanInc; // Index of the scan within the current geometry
 
-    QVector<QPointF>::const_iterator _pntIt; // Laser Point Iterator
+    GeometryView _curGeom;
+    ArcLengthTable::ConstPtr _curTable;
 };
 
 } // End of namespace SLM
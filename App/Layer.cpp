@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <exception>
 
+#include "GeometryStore.h"
 #include "Layer.h"
 
 using namespace slm;
@@ -23,19 +24,30 @@ LayerGeometry::~LayerGeometry()
 Layer::Layer() : lid(0),
                  z(0),
                  mLayerPos(0),
-                 mIsLoaded(false)
+                 mIsLoaded(false),
+                 mPinCount(0),
+                 mStoreGeometryValid(false),
+                 mTypeIndexValid(false)
 {
+    invalidateIndex();
 }
 
 Layer::Layer(uint64_t id, uint64_t zVal) :  lid(id),
                                             z(zVal),
                                             mLayerPos(0),
-                                            mIsLoaded(false)
+                                            mIsLoaded(false),
+                                            mPinCount(0),
+                                            mStoreGeometryValid(false),
+                                            mTypeIndexValid(false)
 {
+    invalidateIndex();
 }
 
 Layer::~Layer()
 {
+    if(mLoader)
+        mLoader->release(*this);
+
     mGeometry.clear();
 }
 
@@ -57,6 +69,10 @@ void Layer::setZ(const uint64_t &val)
 void Layer::clear()
 {
     mGeometry.clear();
+    mStore.reset();
+    mStoreGeometry.clear();
+    mStoreGeometryValid = false;
+    invalidateIndex();
 }
 
 void Layer::setIsLoaded(const bool &isLoaded)
@@ -64,17 +80,342 @@ void Layer::setIsLoaded(const bool &isLoaded)
     mIsLoaded = isLoaded;
 }
 
+void Layer::ensureLoaded() const
+{
+    if(!mLoader)
+        return;
+
+    // Loading the geometry on demand does not change the logical state of the layer
+    Layer &layer = const_cast<Layer &>(*this);
+
+    if(mIsLoaded)
+        mLoader->access(layer);
+    else
+        mLoader->load(layer);
+}
+
+bool Layer::unload()
+{
+    if(!mLoader || isPinned())
+        return false;
+
+    clear();
+    mIsLoaded = false;
+
+    return true;
+}
+
+void Layer::pin() const
+{
+    // The pin is taken before loading, so that the layer cannot be unloaded once loaded
+    mPinCount++;
+    ensureLoaded();
+}
+
+void Layer::unpin() const
+{
+    mPinCount--;
+}
+
+LayerPin::LayerPin(const Layer *layer) : mLayer(layer)
+{
+    if(mLayer)
+        mLayer->pin();
+}
+
+LayerPin::LayerPin(const LayerPin &other) : mLayer(other.mLayer)
+{
+    if(mLayer)
+        mLayer->pin();
+}
+
+LayerPin::~LayerPin()
+{
+    if(mLayer)
+        mLayer->unpin();
+}
+
+LayerPin & LayerPin::operator=(const LayerPin &other)
+{
+    reset(other.mLayer);
+    return *this;
+}
+
+void LayerPin::reset(const Layer *layer)
+{
+    if(layer)
+        layer->pin();
+
+    if(mLayer)
+        mLayer->unpin();
+
+    mLayer = layer;
+}
+
+uint64_t Layer::memoryUsage() const
+{
+    uint64_t bytes = 0;
+
+    if(mStore) {
+
+        // Geometry referenced from a memory mapped file is held by the page cache rather than the layer
+        for(size_t i = 0; i < mStoreCount && !mStore->isExternal(); i++) {
+            const GeometryView view = mStore->at(mStoreFirst + i);
+            bytes += view.rows * view.cols * sizeof(float) + sizeof(uint8_t) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+        }
+
+        for(auto geom : mStoreGeometry)
+            bytes += sizeof(LayerGeometry) + geom->coords.size() * sizeof(float);
+
+    } else {
+        for(auto geom : mGeometry)
+            bytes += sizeof(LayerGeometry) + geom->coords.size() * sizeof(float);
+    }
+
+    return bytes;
+}
+
 void Layer::setGeometry(const std::vector<LayerGeometry::Ptr> &geoms) {
+    mStore.reset();
+    mStoreGeometry.clear();
+    mStoreGeometryValid = false;
     mGeometry = geoms;
+    invalidateIndex();
+}
+
+const std::vector<LayerGeometry::Ptr> & Layer::geometry() const
+{
+    ensureLoaded();
+
+    if(!mStore)
+        return mGeometry;
+
+    // Create the LayerGeometry objects from the store upon first access
+    if(!mStoreGeometryValid) {
+
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+
+        if(!mStoreGeometryValid) {
+            mStoreGeometry.clear();
+            mStoreGeometry.reserve(mStoreCount);
+
+            for(size_t i = 0; i < mStoreCount; i++)
+                mStoreGeometry.push_back(mStore->createGeometry(mStoreFirst + i));
+
+            mStoreGeometryValid = true;
+        }
+    }
+
+    return mStoreGeometry;
+}
+
+std::vector<LayerGeometry::Ptr> & Layer::geometryRef()
+{
+    // The geometry may be modified by the caller so the layer cannot remain backed by the store
+    detachStore();
+    invalidateIndex();
+    return mGeometry;
+}
+
+void Layer::detachStore()
+{
+    ensureLoaded();
+
+    if(!mStore)
+        return;
+
+    geometry();
+
+    mGeometry.swap(mStoreGeometry);
+    mStoreGeometry.clear();
+    mStoreGeometryValid = false;
+    mStore.reset();
+    mStoreFirst = 0;
+    mStoreCount = 0;
+}
+
+void Layer::setGeometryStore(std::shared_ptr<GeometryStore> store, size_t first, size_t count)
+{
+    mGeometry.clear();
+    mStoreGeometry.clear();
+    mStoreGeometryValid = false;
+    invalidateIndex();
+
+    if(!store || first > store->size()) {
+        mStore.reset();
+        mStoreFirst = 0;
+        mStoreCount = 0;
+        return;
+    }
+
+    mStore = store;
+    mStoreFirst = first;
+    mStoreCount = std::min(count, store->size() - first);
+}
+
+void Layer::compactGeometry()
+{
+    ensureLoaded();
+
+    if(mStore)
+        return;
+
+    GeometryStore::Ptr store = GeometryStore::fromGeometry(mGeometry);
+
+    if(store)
+        setGeometryStore(store);
+}
+
+size_t Layer::numGeometry() const
+{
+    ensureLoaded();
+
+    return mStore ? mStoreCount : mGeometry.size();
+}
+
+GeometryView Layer::geometryView(size_t idx) const
+{
+    ensureLoaded();
+
+    return storedView(idx);
+}
+
+GeometryView Layer::storedView(size_t idx) const
+{
+    if(mStore)
+        return mStore->at(mStoreFirst + idx);
+
+    const LayerGeometry &geom = *mGeometry[idx];
+
+    return GeometryView(geom.getType(), geom.mid, geom.bid,
+                        geom.coords.data(), geom.coords.rows(), geom.coords.cols());
+}
+
+LayerGeometry::Ptr Layer::geometryAt(size_t idx) const
+{
+    const LayerPin pin(this);
+
+    if(!mStore)
+        return mGeometry[idx];
+
+    // Objects already created by geometry() are shared
+    if(mStoreGeometryValid)
+        return mStoreGeometry[idx];
+
+    return mStore->createGeometry(mStoreFirst + idx);
+}
+
+GeometryViewRange Layer::geometryViews() const
+{
+    const LayerPin pin(this);
+
+    return GeometryViewRange(this, numGeometry());
+}
+
+GeometryView GeometryViewRange::at(size_t idx) const
+{
+    // The layer was loaded when the range was created
+    return mLayer->storedView(index(idx));
+}
+
+void Layer::invalidateIndex()
+{
+    mTypeIndexValid = false;
+
+    for(auto &valid : mScanOrderValid)
+        valid = false;
+}
+
+void Layer::indexAppendedGeometry()
+{
+    // Only extend a valid index which does not yet include the appended geometry
+    if(!mTypeIndexValid || mTypeIndexCount + 1 != mGeometry.size()) {
+        invalidateIndex();
+        return;
+    }
+
+    for(auto &valid : mScanOrderValid)
+        valid = false;
+
+    int type = mGeometry.back()->getType();
+
+    if(type < LayerGeometry::INVALID || type > LayerGeometry::PNTS)
+        type = LayerGeometry::INVALID;
+
+    mTypeIndex[type].push_back(mTypeIndexCount++);
 }
 
+void Layer::buildTypeIndex() const
+{
+    const size_t numGeoms = mStore ? mStoreCount : mGeometry.size();
+
+    for(auto &index : mTypeIndex)
+        index.clear();
+
+    for(size_t i = 0; i < numGeoms; i++) {
+        int geomType = mStore ? storedView(i).type : mGeometry[i]->getType();
+
+        if(geomType < LayerGeometry::INVALID || geomType > LayerGeometry::PNTS)
+            geomType = LayerGeometry::INVALID;
+
+        mTypeIndex[geomType].push_back(i);
+    }
+
+    mTypeIndexCount = numGeoms;
+}
+
+const std::vector<uint32_t> & Layer::geometryIndicesByType(LayerGeometry::TYPE type) const
+{
+    ensureLoaded();
+
+    // The index is only rebuilt once invalidated, as edits through geometryRef() are not tracked
+    if(!mTypeIndexValid) {
+
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+
+        if(!mTypeIndexValid) {
+            buildTypeIndex();
+            mTypeIndexValid = true;
+        }
+    }
+
+    if(type < LayerGeometry::INVALID || type > LayerGeometry::PNTS)
+        type = LayerGeometry::INVALID;
+
+    return mTypeIndex[type];
+}
+
+GeometryViewRange Layer::geometryViewsByType(LayerGeometry::TYPE type) const
+{
+    // The layer is pinned before the index is obtained, so that it cannot be unloaded in between
+    const LayerPin pin(this);
+    const std::vector<uint32_t> &index = geometryIndicesByType(type);
+
+    return GeometryViewRange(this, index.size(), index.data());
+}
+
+std::vector<LayerGeometry::Ptr> Layer::getGeometryByType(LayerGeometry::TYPE type) const
+{
+    const std::vector<uint32_t> &index = geometryIndicesByType(type);
+    const std::vector<LayerGeometry::Ptr> &geoms = geometry();
+
+    std::vector<LayerGeometry::Ptr> geomList;
+    geomList.reserve(index.size());
+
+    for(auto idx : index)
+        geomList.push_back(geoms[idx]);
+
+    return geomList;
+}
 
 void Layer::appendGeometry(LayerGeometry::Ptr geom)
 {
     if(!geom)
         return;
 
+    detachStore();
     mGeometry.push_back(geom);
+    indexAppendedGeometry();
 }
 
 int64_t Layer::addContourGeometry(LayerGeometry::Ptr geom)
@@ -84,7 +425,9 @@ int64_t Layer::addContourGeometry(LayerGeometry::Ptr geom)
 
     assert(geom->getType() == LayerGeometry::POLYGON);
 
+    detachStore();
     mGeometry.push_back(geom);
+    indexAppendedGeometry();
 
     return mGeometry.size();
 }
@@ -96,7 +439,9 @@ int64_t Layer::addHatchGeometry(LayerGeometry::Ptr geom)
 
     assert(geom->getType() == LayerGeometry::HATCH);
 
+    detachStore();
     mGeometry.push_back(geom);
+    indexAppendedGeometry();
 
     return mGeometry.size();
 }
@@ -108,83 +453,106 @@ int64_t Layer::addPntsGeometry(LayerGeometry::Ptr geom)
 
     assert(geom->getType() == LayerGeometry::PNTS);
 
+    detachStore();
     mGeometry.push_back(geom);
+    indexAppendedGeometry();
+
     return mGeometry.size(); // Return updated size
 }
 
 
 std::vector<LayerGeometry::Ptr > Layer::getContourGeometry() const
 {
-    std::vector<LayerGeometry::Ptr> contourGeomList;
+    return getGeometryByType(LayerGeometry::POLYGON);
+}
 
-    for(auto geom : mGeometry) {
-        if (geom->getType() == LayerGeometry::POLYGON)
-            contourGeomList.push_back(geom);
-    }
+std::vector<LayerGeometry::Ptr > Layer::getHatchGeometry() const
+{
+    return getGeometryByType(LayerGeometry::HATCH);
+}
 
-    return contourGeomList;
+std::vector<LayerGeometry::Ptr > Layer::getPntsGeometry() const
+{
+    return getGeometryByType(LayerGeometry::PNTS);
 }
 
-std::vector<LayerGeometry::Ptr > Layer::getHatchGeometry() const
+const std::vector<uint32_t> & Layer::geometryOrder(ScanMode mode) const
 {
-    std::vector<LayerGeometry::Ptr> geomList;
+    if(mode != HATCH_FIRST && mode != CONTOUR_FIRST)
+        mode = NONE;
+
+    // Ensure the type index is current, which invalidates any stale orderings
+    const std::vector<uint32_t> &hatch   = geometryIndicesByType(LayerGeometry::HATCH);
+    const std::vector<uint32_t> &contour = geometryIndicesByType(LayerGeometry::POLYGON);
+    const std::vector<uint32_t> &points  = geometryIndicesByType(LayerGeometry::PNTS);
+
+    std::vector<uint32_t> &order = mScanOrder[mode];
+
+    if(mScanOrderValid[mode])
+        return order;
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    if(mScanOrderValid[mode])
+        return order;
+
+    order.clear();
+
+    if(mode == HATCH_FIRST ||
+       mode == CONTOUR_FIRST) {
+
+        order.reserve(hatch.size() + contour.size() + points.size());
+
+        if(mode == HATCH_FIRST) {
+            order.insert(order.end(), hatch.begin(), hatch.end());
+            order.insert(order.end(), contour.begin(), contour.end());
+        } else {
+            order.insert(order.end(), contour.begin(), contour.end());
+            order.insert(order.end(), hatch.begin(), hatch.end());
+        }
 
-    for(auto geom : mGeometry) {
-        if (geom->getType() == LayerGeometry::HATCH)
-            geomList.push_back(geom);
+        order.insert(order.end(), points.begin(), points.end());
+
+    } else {
+
+        order.resize(mTypeIndexCount);
+
+        for(size_t i = 0; i < order.size(); i++)
+            order[i] = i;
     }
 
-    return geomList;
+    mScanOrderValid[mode] = true;
+
+    return order;
 }
 
-std::vector<LayerGeometry::Ptr > Layer::getPntsGeometry() const
+GeometryViewRange Layer::geometryViews(ScanMode mode) const
 {
-    std::vector<LayerGeometry::Ptr> geomList;
-
-    for(auto geom : mGeometry) {
-        if (geom->getType() == LayerGeometry::PNTS)
-            geomList.push_back(geom);
-    }
+    // The layer is pinned before the ordering is obtained, so that it cannot be unloaded in between
+    const LayerPin pin(this);
+    const std::vector<uint32_t> &order = geometryOrder(mode);
 
-    return geomList;
+    return GeometryViewRange(this, order.size(), order.data());
 }
 
 std::vector<LayerGeometry::Ptr > Layer::getGeometry(ScanMode mode) const
 {
-
     if(mode == HATCH_FIRST ||
        mode == CONTOUR_FIRST) {
 
-        std::vector<LayerGeometry::Ptr > hatch;
-        std::vector<LayerGeometry::Ptr > contour;
-        std::vector<LayerGeometry::Ptr > points;
-
-        for(auto it = mGeometry.cbegin(); it != mGeometry.cend(); ++it) {
-           if((*it)->getType() == LayerGeometry::PNTS) {
-               points.push_back(*it);
-           } else if((*it)->getType() == LayerGeometry::POLYGON) {
-               contour.push_back(*it);
-           } else if((*it)->getType() == LayerGeometry::HATCH) {
-               hatch.push_back(*it);
-           }
-        }
-
-        std::vector<LayerGeometry::Ptr >list;
+        const std::vector<uint32_t> &order = geometryOrder(mode);
+        const std::vector<LayerGeometry::Ptr> &geoms = geometry();
 
-        if(mode == HATCH_FIRST) {
-            list.insert(list.end(), hatch.begin(), hatch.end());
-            list.insert(list.end(), contour.begin(), contour.end());
-        } else {
-            list.insert(list.end(), contour.begin(), contour.end());
-            list.insert(list.end(), hatch.begin(), hatch.end());
-        }
+        std::vector<LayerGeometry::Ptr > list;
+        list.reserve(order.size());
 
-        list.insert(list.end(), points.begin(), points.end());
+        for(auto idx : order)
+            list.push_back(geoms[idx]);
 
         return list;
 
     } else {
-        return mGeometry;
+        return geometry();
     }
 }
 
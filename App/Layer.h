@@ -3,9 +3,11 @@
 
 #include "SLM_Export.h"
 
+#include <atomic>
 #include <cstdint>
-#include <vector>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -71,8 +73,142 @@ public:
     virtual TYPE getType() const { return type; }
 };
 
+/**
+ * @brief The GeometryView class is a lightweight, non-owning view of a single geometry block. It is valid as long as
+ * the layer (or GeometryStore) it was obtained from is not modified.
+ */
+class SLM_EXPORT GeometryView
+{
+public:
+    GeometryView() {}
+    GeometryView(LayerGeometry::TYPE geomType, uint32_t modelId, uint32_t buildStyleId,
+                 const float *coordData, uint64_t numRows, uint64_t numCols) : type(geomType),
+                                                                               mid(modelId),
+                                                                               bid(buildStyleId),
+                                                                               data(coordData),
+                                                                               rows(numRows),
+                                                                               cols(numCols) {}
+
+    Eigen::Map<const Eigen::MatrixXf> coords() const { return Eigen::Map<const Eigen::MatrixXf>(data, rows, cols); }
+    uint64_t numPoints() const { return rows; }
+
+public:
+    LayerGeometry::TYPE type = LayerGeometry::INVALID;
+    uint32_t mid = 0;
+    uint32_t bid = 0;
+    const float *data = nullptr;
+    uint64_t rows = 0;
+    uint64_t cols = 0;
+};
+
+class Layer;
+class GeometryStore;
+
+/**
+ * @brief The LayerPin class pins a layer whilst it is held, loading the layer if required. A pinned layer is not
+ * unloaded, so that data obtained from it, such as a GeometryView, remains valid whilst the layer is pinned.
+ */
+class SLM_EXPORT LayerPin
+{
+public:
+    explicit LayerPin(const Layer *layer = nullptr);
+    LayerPin(const LayerPin &other);
+    ~LayerPin();
+
+    LayerPin & operator=(const LayerPin &other);
+
+    void reset(const Layer *layer = nullptr);
+    const Layer * layer() const { return mLayer; }
+
+private:
+    const Layer *mLayer;
+};
+
+/**
+ * @brief The GeometryViewRange class iterates the geometry of a Layer as GeometryView without allocation,
+ * regardless if the layer is backed by LayerGeometry objects or by a GeometryStore. The range optionally
+ * refers to a subset of the layer geometry given by a list of geometry indices owned by the layer. The layer is
+ * pinned for the lifetime of the range, so the views remain valid whilst the range is held.
+ */
+class SLM_EXPORT GeometryViewRange
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator(const GeometryViewRange *range, size_t idx) : mRange(range), mIdx(idx) {}
+
+        GeometryView operator*() const { return mRange->at(mIdx); }
+        const_iterator & operator++() { ++mIdx; return *this; }
+        bool operator==(const const_iterator &other) const { return mIdx == other.mIdx; }
+        bool operator!=(const const_iterator &other) const { return mIdx != other.mIdx; }
+
+    private:
+        const GeometryViewRange *mRange;
+        size_t mIdx;
+    };
+
+    GeometryViewRange() : mLayer(nullptr), mCount(0), mIndices(nullptr) {}
+    GeometryViewRange(const Layer *layer, size_t count, const uint32_t *indices = nullptr) : mLayer(layer),
+                                                                                           mCount(count),
+                                                                                           mIndices(indices),
+                                                                                           mPin(layer) {}
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, mCount); }
+    size_t size() const { return mCount; }
+    bool empty() const { return mCount == 0; }
+
+    GeometryView at(size_t idx) const;
+
+    // Index of the geometry within the layer
+    size_t index(size_t idx) const { return mIndices ? mIndices[idx] : idx; }
+
+    const Layer * layer() const { return mLayer; }
+
+private:
+    const Layer *mLayer;
+    size_t mCount;
+    const uint32_t *mIndices;
+    LayerPin mPin;
+};
+
+/**
+ * @brief The LayerLoader class loads the geometry of a Layer on demand. A layer with a loader which is not loaded
+ * requests its geometry from the loader upon first access.
+ */
+class SLM_EXPORT LayerLoader
+{
+public:
+    typedef std::shared_ptr<LayerLoader> Ptr;
+
+    virtual ~LayerLoader() {}
+
+    // Loads the geometry of the layer and marks it as loaded
+    virtual void load(Layer &layer) = 0;
+
+    // Called upon each access of the geometry of a loaded layer
+    virtual void access(Layer &layer) {}
+
+    // Called when the layer is destroyed
+    virtual void release(Layer &layer) {}
+};
+
+/**
+ * @brief The LayerIndexEntry struct locates the record of a layer within the build file
+ */
+struct LayerIndexEntry
+{
+    uint64_t layerId = 0;
+    uint64_t z = 0;
+    uint64_t offset = 0; // Byte offset of the layer record
+    uint64_t length = 0; // Byte length of the layer record
+};
+
 class SLM_EXPORT Layer
 {
+    friend class GeometryViewRange;
+
 public:
 
     typedef std::shared_ptr<Layer> Ptr;
@@ -93,13 +229,31 @@ public:
     void setLayerFilePosition(const uint64_t &position);
     void setIsLoaded(const bool &isLoaded);
 
+    /*
+     * On-demand loading. The geometry is loaded by the loader upon first access and may later be released by
+     * unload(). References to the geometry of the layer are invalidated when it is unloaded, unless the layer is
+     * pinned by a LayerPin or GeometryViewRange. Pinned layers are not unloaded.
+     */
+    void setLoader(LayerLoader::Ptr loader) { mLoader = loader; }
+    LayerLoader::Ptr loader() const { return mLoader; }
+    bool unload();
+
+    void pin() const;
+    void unpin() const;
+    bool isPinned() const { return mPinCount > 0; }
+
+    // Approximate memory used by the geometry of the layer in bytes
+    uint64_t memoryUsage() const;
+
     // Add different types of geometry to each layer
     template <class T>
     int64_t addGeometry(typename T::Ptr geom) {
         if(!geom)
             return -1;
 
+        detachStore();
         mGeometry.push_back(geom);
+        indexAppendedGeometry();
 
         return mGeometry.size();
     }
@@ -111,21 +265,59 @@ public:
     int64_t addPntsGeometry(LayerGeometry::Ptr geom);
 
 
-    const std::vector<LayerGeometry::Ptr> & geometry() const { return mGeometry; }
+    const std::vector<LayerGeometry::Ptr> & geometry() const;
 
-    std::vector<LayerGeometry::Ptr> & geometryRef()  { return mGeometry; }
+    /*
+     * Returns the geometry for modification. The type index and scan orders are invalidated when the reference is
+     * returned, but later edits through the reference are not tracked. invalidateIndex() must be called after the
+     * geometry is modified through a previously obtained reference.
+     */
+    std::vector<LayerGeometry::Ptr> & geometryRef();
+    void invalidateIndex();
 
     void setGeometry(const std::vector<LayerGeometry::Ptr> &geoms);
 
+    /*
+     * Contiguous geometry storage. The layer references the range [first, first + count) of a store, which may be
+     * shared across the build. Accessing geometry() on a store backed layer creates LayerGeometry objects on demand,
+     * whilst geometryViews() provides direct access to the store. Any modification of the layer geometry detaches
+     * the layer from the store.
+     */
+    void setGeometryStore(std::shared_ptr<GeometryStore> store, size_t first = 0, size_t count = SIZE_MAX);
+    std::shared_ptr<GeometryStore> geometryStore() const { return mStore; }
+    bool hasGeometryStore() const { return mStore != nullptr; }
+    void compactGeometry();
+
+    size_t numGeometry() const;
+    GeometryView geometryView(size_t idx) const;
+
+    // Returns a single geometry, which for a store backed layer is created without creating the entire geometry()
+    LayerGeometry::Ptr geometryAt(size_t idx) const;
+    GeometryViewRange geometryViews() const;
+
+    /*
+     * Per-type geometry indices. The indices are maintained as geometry is added to the layer, so that typed
+     * queries and counts do not require a pass over the entire layer. The indices and the scan orders below are
+     * built on first access, which may be made concurrently provided the layer is not modified.
+     */
+    const std::vector<uint32_t> & geometryIndicesByType(LayerGeometry::TYPE type) const;
+    size_t numGeometryByType(LayerGeometry::TYPE type) const { return geometryIndicesByType(type).size(); }
+    GeometryViewRange geometryViewsByType(LayerGeometry::TYPE type) const;
+
     template <class T>
-    std::vector<LayerGeometry::Ptr> getGeometryByType () {
-        std::vector<LayerGeometry::Ptr> geoms;
-        for(LayerGeometry::Ptr geom : mGeometry) {
-            if(geom->getType() == T::type){geoms.push_back(geom);}
-        }
-        return geoms;
+    std::vector<LayerGeometry::Ptr> getGeometryByType () const {
+        return getGeometryByType(T::type);
     }
 
+    std::vector<LayerGeometry::Ptr> getGeometryByType(LayerGeometry::TYPE type) const;
+
+    /*
+     * Geometry ordered by the scan mode. The ordering is computed once per scan mode as a permutation of the layer
+     * geometry indices and cached until the layer geometry is modified.
+     */
+    const std::vector<uint32_t> & geometryOrder(ScanMode mode) const;
+    GeometryViewRange geometryViews(ScanMode mode) const;
+
     std::vector<LayerGeometry::Ptr> getGeometry(ScanMode mode = NONE) const;
     std::vector<LayerGeometry::Ptr> getContourGeometry() const;
     std::vector<LayerGeometry::Ptr> getHatchGeometry() const;
@@ -140,11 +332,38 @@ public:
     bool isLoaded() const { return mIsLoaded; }
 
 protected:
+    void ensureLoaded() const;
+    GeometryView storedView(size_t idx) const;
+    void detachStore();
+    void indexAppendedGeometry();
+    void buildTypeIndex() const;
+
     uint64_t lid = 0;    // Layer ID
     uint64_t z = 0;      // Z Layer Position
     uint64_t mLayerPos;
     std::vector<LayerGeometry::Ptr> mGeometry;
-    bool mIsLoaded;
+    std::atomic<bool> mIsLoaded;
+    mutable std::atomic<uint32_t> mPinCount;
+
+    LayerLoader::Ptr mLoader;
+
+    std::shared_ptr<GeometryStore> mStore;
+    size_t mStoreFirst = 0;
+    size_t mStoreCount = 0;
+    mutable std::vector<LayerGeometry::Ptr> mStoreGeometry; // LayerGeometry created on demand from the store
+    mutable std::atomic<bool> mStoreGeometryValid;
+
+    // Guards building the caches below upon concurrent access. Each cache is read only once marked as valid.
+    mutable std::mutex mCacheMutex;
+
+    // Geometry indices for each LayerGeometry::TYPE, rebuilt on demand when invalidated
+    mutable std::vector<uint32_t> mTypeIndex[LayerGeometry::PNTS + 1];
+    mutable size_t mTypeIndexCount = 0;
+    mutable std::atomic<bool> mTypeIndexValid;
+
+    // Cached geometry permutation for each ScanMode
+    mutable std::vector<uint32_t> mScanOrder[HATCH_FIRST + 1];
+    mutable std::atomic<bool> mScanOrderValid[HATCH_FIRST + 1];
 };
 
 using HatchGeometry   = slm::LayerGeometryT<LayerGeometry::HATCH>;
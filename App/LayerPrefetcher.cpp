@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+#include "LayerPrefetcher.h"
+
+using namespace slm;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(const Clock::time_point &start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // End of anonymous namespace
+
+LayerPrefetcher::LayerPrefetcher(size_t count, const DecodeFunction &decode, size_t depth) : mCount(count),
+                                                                                          mDecode(decode),
+                                                                                          mFinished(false),
+                                                                                          mFailed(false),
+                                                                                          mStop(false)
+{
+    mStats.depth = std::max<size_t>(1, depth);
+    mThread = std::thread(&LayerPrefetcher::run, this);
+}
+
+LayerPrefetcher::~LayerPrefetcher()
+{
+    this->stop();
+}
+
+void LayerPrefetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+
+    mNotFull.notify_all();
+    mNotEmpty.notify_all();
+
+    if(mThread.joinable())
+        mThread.join();
+}
+
+void LayerPrefetcher::run()
+{
+    for(size_t i = 0; i < mCount; i++) {
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+
+            // Wait whilst the consumer is depth layers behind
+            if(mQueue.size() >= mStats.depth && !mStop) {
+
+                const Clock::time_point start = Clock::now();
+
+                mNotFull.wait(lock, [this] { return mQueue.size() < mStats.depth || mStop; });
+
+                mStats.producerStalls++;
+                mStats.producerStallTime += secondsSince(start);
+            }
+
+            if(mStop)
+                break;
+        }
+
+        Layer::Ptr layer;
+
+        try {
+            layer = mDecode(i);
+        } catch(const std::exception &e) {
+            layer.reset();
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if(!layer) {
+            mFailed = true;
+            break;
+        }
+
+        mQueue.push_back(layer);
+        mStats.numDecoded++;
+        mStats.maxQueueSize = std::max(mStats.maxQueueSize, mQueue.size());
+
+        mNotEmpty.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFinished = true;
+    mNotEmpty.notify_all();
+}
+
+Layer::Ptr LayerPrefetcher::next()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if(mQueue.empty() && !mFinished && !mStop) {
+
+        const Clock::time_point start = Clock::now();
+
+        mNotEmpty.wait(lock, [this] { return !mQueue.empty() || mFinished || mStop; });
+
+        mStats.consumerStalls++;
+        mStats.consumerStallTime += secondsSince(start);
+    }
+
+    if(mQueue.empty())
+        return Layer::Ptr();
+
+    Layer::Ptr layer = mQueue.front();
+    mQueue.pop_front();
+
+    mStats.numConsumed++;
+
+    mNotFull.notify_one();
+
+    return layer;
+}
+
+bool LayerPrefetcher::hasFailed() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFailed;
+}
+
+PrefetchStats LayerPrefetcher::stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    PrefetchStats stats = mStats;
+    stats.queueSize = mQueue.size();
+
+    return stats;
+}
@@ -0,0 +1,87 @@
+#ifndef SLM_LAYERPREFETCHER_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_LAYERPREFETCHER_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "Layer.h"
+
+namespace slm
+{
+
+/**
+ * @brief The PrefetchStats struct reports the behaviour of a LayerPrefetcher. A consumer stall occurs when the next
+ * layer has not been decoded when requested, and a producer stall when the queue is full.
+ */
+struct PrefetchStats
+{
+    size_t   depth           = 0;   // Maximum number of layers held in the queue
+    size_t   queueSize       = 0;   // Current number of layers held in the queue
+    size_t   maxQueueSize    = 0;
+    uint64_t numDecoded      = 0;
+    uint64_t numConsumed     = 0;
+    uint64_t consumerStalls  = 0;
+    double   consumerStallTime = 0.0;  // seconds
+    uint64_t producerStalls  = 0;
+    double   producerStallTime = 0.0;  // seconds
+};
+
+/**
+ * @brief The LayerPrefetcher class decodes layers in order on a background thread, remaining up to depth layers ahead
+ * of the consumer so that reading and decoding overlaps with the processing of the previous layers.
+ */
+class SLM_EXPORT LayerPrefetcher
+{
+public:
+    /**
+     * Decodes the layer at the index within the build, returning a null pointer on failure
+     */
+    typedef std::function<Layer::Ptr(size_t idx)> DecodeFunction;
+
+    LayerPrefetcher(size_t count, const DecodeFunction &decode, size_t depth = 8);
+    ~LayerPrefetcher();
+
+    LayerPrefetcher(const LayerPrefetcher &) = delete;
+    LayerPrefetcher & operator=(const LayerPrefetcher &) = delete;
+
+public:
+    /**
+     * Returns the next layer in order, waiting until it has been decoded
+     * @return The layer, or a null pointer once all layers are consumed or if decoding failed
+     */
+    Layer::Ptr next();
+
+    // Stops decoding further layers and waits for the background thread to finish
+    void stop();
+
+    bool hasFailed() const;
+    size_t size() const { return mCount; }
+    PrefetchStats stats() const;
+
+private:
+    void run();
+
+    const size_t mCount;
+    const DecodeFunction mDecode;
+
+    std::deque<Layer::Ptr> mQueue;
+    bool mFinished;
+    bool mFailed;
+    bool mStop;
+
+    PrefetchStats mStats;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mNotFull;
+    std::condition_variable mNotEmpty;
+    std::thread mThread;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_LAYERPREFETCHER_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,158 @@
+#include <iostream>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+using namespace slm;
+
+MappedFile::MappedFile() : mData(nullptr),
+                           mSize(0),
+                           mIsOpen(false)
+#ifdef _WIN32
+                         , mFileHandle(nullptr),
+                           mMappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::MappedFile(const std::string &path) : MappedFile()
+{
+    this->open(path);
+}
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path)
+{
+    this->close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if(file == INVALID_HANDLE_VALUE) {
+        std::cerr << "File '" << path << "' could not be opened for mapping" << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    mFileHandle = file;
+    mSize = static_cast<size_t>(fileSize.QuadPart);
+
+    // Empty files cannot be mapped but are still valid to read
+    if(mSize > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+        if(!mapping) {
+            std::cerr << "File '" << path << "' could not be mapped" << std::endl;
+            this->close();
+            return false;
+        }
+
+        mMappingHandle = mapping;
+        mData = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+        if(!mData) {
+            std::cerr << "File '" << path << "' could not be mapped" << std::endl;
+            this->close();
+            return false;
+        }
+    }
+
+    mFilePath = path;
+    mIsOpen = true;
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mData)
+        UnmapViewOfFile(mData);
+
+    if(mMappingHandle)
+        CloseHandle(static_cast<HANDLE>(mMappingHandle));
+
+    if(mFileHandle)
+        CloseHandle(static_cast<HANDLE>(mFileHandle));
+
+    mData = nullptr;
+    mMappingHandle = nullptr;
+    mFileHandle = nullptr;
+    mSize = 0;
+    mIsOpen = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path)
+{
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if(fd < 0) {
+        std::cerr << "File '" << path << "' could not be opened for mapping" << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    mSize = static_cast<size_t>(st.st_size);
+
+    // Empty files cannot be mapped but are still valid to read
+    if(mSize > 0) {
+        void *addr = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+
+        if(addr == MAP_FAILED) {
+            std::cerr << "File '" << path << "' could not be mapped" << std::endl;
+            ::close(fd);
+            mSize = 0;
+            return false;
+        }
+
+        mData = static_cast<const uint8_t *>(addr);
+    }
+
+    // The mapping remains valid after the descriptor is closed
+    ::close(fd);
+
+    mFilePath = path;
+    mIsOpen = true;
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mData)
+        munmap(const_cast<uint8_t *>(mData), mSize);
+
+    mData = nullptr;
+    mSize = 0;
+    mIsOpen = false;
+}
+
+#endif
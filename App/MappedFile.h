@@ -0,0 +1,214 @@
+#ifndef SLM_MAPPEDFILE_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_MAPPEDFILE_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace slm
+{
+
+/**
+ * @brief The ByteSpan struct is a non-owning view of a contiguous region of bytes
+ */
+struct ByteSpan
+{
+    ByteSpan() : data(nullptr), size(0) {}
+    ByteSpan(const uint8_t *ptr, size_t len) : data(ptr), size(len) {}
+
+    bool empty() const { return size == 0; }
+    const uint8_t *begin() const { return data; }
+    const uint8_t *end() const { return data + size; }
+
+    ByteSpan subspan(size_t offset, size_t len) const
+    {
+        if(offset > size || len > size - offset)
+            throw std::out_of_range("ByteSpan::subspan - region exceeds span");
+
+        return ByteSpan(data + offset, len);
+    }
+
+    const uint8_t *data;
+    size_t size;
+};
+
+/**
+ * @brief The ByteCursor class provides bounds-checked sequential reads from a ByteSpan. Reads past the end of the
+ * span throw std::out_of_range and leave the cursor position unchanged.
+ */
+class SLM_EXPORT ByteCursor
+{
+public:
+    ByteCursor() : mPos(0) {}
+    ByteCursor(const ByteSpan &span, size_t pos = 0) : mSpan(span), mPos(pos) {}
+
+public:
+    size_t position() const { return mPos; }
+    size_t size() const { return mSpan.size; }
+    size_t remaining() const { return mSpan.size - mPos; }
+    bool atEnd() const { return mPos >= mSpan.size; }
+    bool canRead(size_t len) const { return len <= remaining(); }
+
+    const ByteSpan & span() const { return mSpan; }
+    const uint8_t *current() const { return mSpan.data + mPos; }
+
+    void seek(size_t pos)
+    {
+        if(pos > mSpan.size)
+            throw std::out_of_range("ByteCursor::seek - position exceeds span");
+
+        mPos = pos;
+    }
+
+    void skip(size_t len)
+    {
+        require(len);
+        mPos += len;
+    }
+
+    /**
+     * Returns a zero-copy span of the next len bytes and advances the cursor
+     */
+    ByteSpan readSpan(size_t len)
+    {
+        require(len);
+        ByteSpan region(mSpan.data + mPos, len);
+        mPos += len;
+        return region;
+    }
+
+    std::string readString(size_t len)
+    {
+        ByteSpan region = readSpan(len);
+        return std::string(reinterpret_cast<const char *>(region.data), len);
+    }
+
+    /**
+     * Reads a value in the byte order of the host
+     */
+    template <class T>
+    T read()
+    {
+        static_assert(std::is_arithmetic<T>::value, "ByteCursor::read requires an arithmetic type");
+
+        require(sizeof(T));
+
+        T val;
+        std::memcpy(&val, mSpan.data + mPos, sizeof(T));
+        mPos += sizeof(T);
+
+        return val;
+    }
+
+    /**
+     * Reads a value stored in little-endian byte order
+     */
+    template <class T>
+    T readLE()
+    {
+        static_assert(std::is_arithmetic<T>::value, "ByteCursor::readLE requires an arithmetic type");
+
+        require(sizeof(T));
+
+        uint8_t bytes[sizeof(T)];
+        for(size_t i = 0; i < sizeof(T); i++)
+            bytes[hostIsLittleEndian() ? i : sizeof(T) - 1 - i] = mSpan.data[mPos + i];
+
+        mPos += sizeof(T);
+
+        T val;
+        std::memcpy(&val, bytes, sizeof(T));
+        return val;
+    }
+
+    /**
+     * Reads a value stored in big-endian byte order
+     */
+    template <class T>
+    T readBE()
+    {
+        static_assert(std::is_arithmetic<T>::value, "ByteCursor::readBE requires an arithmetic type");
+
+        require(sizeof(T));
+
+        uint8_t bytes[sizeof(T)];
+        for(size_t i = 0; i < sizeof(T); i++)
+            bytes[hostIsLittleEndian() ? sizeof(T) - 1 - i : i] = mSpan.data[mPos + i];
+
+        mPos += sizeof(T);
+
+        T val;
+        std::memcpy(&val, bytes, sizeof(T));
+        return val;
+    }
+
+    static bool hostIsLittleEndian()
+    {
+        const uint16_t val = 1;
+        uint8_t byte;
+        std::memcpy(&byte, &val, 1);
+        return byte == 1;
+    }
+
+protected:
+    void require(size_t len) const
+    {
+        if(!canRead(len))
+            throw std::out_of_range("ByteCursor - read exceeds the end of the data");
+    }
+
+    ByteSpan mSpan;
+    size_t mPos;
+};
+
+/**
+ * @brief The MappedFile class maps a file read-only into memory. Pages are loaded on demand by the operating system
+ * and are shared through the page cache with any other process reading the same file.
+ */
+class SLM_EXPORT MappedFile
+{
+public:
+
+    typedef std::shared_ptr<MappedFile> Ptr;
+
+    MappedFile();
+    MappedFile(const std::string &path);
+    ~MappedFile();
+
+    // The mapping is unique to the instance
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+public:
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const { return mIsOpen; }
+    const std::string & filePath() const { return mFilePath; }
+
+    const uint8_t * data() const { return mData; }
+    size_t size() const { return mSize; }
+
+    ByteSpan span() const { return ByteSpan(mData, mSize); }
+    ByteCursor cursor(size_t pos = 0) const { return ByteCursor(span(), pos); }
+
+private:
+    std::string mFilePath;
+    const uint8_t *mData;
+    size_t mSize;
+    bool mIsOpen;
+
+#ifdef _WIN32
+    void *mFileHandle;
+    void *mMappingHandle;
+#endif
+};
+
+} // End of Namespace slm
+
+#endif // SLM_MAPPEDFILE_H_HEADER_HAS_BEEN_INCLUDED
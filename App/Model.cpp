@@ -54,12 +54,14 @@ void BuildStyle::setStyle(uint64_t bid,
 
 
 Model::Model() : id(0),
-                 topSliceNum(0)
+                 topSliceNum(0),
+                 mBuildStyleIndexValid(true)
 {
 }
 
 Model::Model(uint64_t mid, uint64_t topSliceNum) : id(mid),
-                                                   topSliceNum(topSliceNum)
+                                                   topSliceNum(topSliceNum),
+                                                   mBuildStyleIndexValid(true)
 {
 }
 
@@ -85,19 +87,47 @@ std::string Model::getBuildStlyeDescriptionAsString() const
 void Model::clear()
 {
     this->mBuildStyles.clear();
+    this->mBuildStyleIndex.clear();
+    this->mBuildStyleIndexValid = true;
+}
+
+void Model::setBuildStyles(const std::vector<BuildStyle::Ptr> &bstyles)
+{
+    mBuildStyles = bstyles;
+    this->reindexBuildStyles();
+}
+
+void Model::reindexBuildStyles()
+{
+    mBuildStyleIndex.clear();
+    mBuildStyleIndex.reserve(mBuildStyles.size());
+
+    // The first build style of each id is retained, matching the previous search order
+    for(size_t i = 0; i < mBuildStyles.size(); i++)
+        mBuildStyleIndex.emplace(mBuildStyles[i]->id, i);
+
+    mBuildStyleIndexValid = true;
 }
 
 BuildStyle::Ptr Model::getBuildStyleById(const uint64_t bid) const
 {
-    auto result = std::find_if(std::begin(mBuildStyles), std::end(mBuildStyles),
-                             [&](BuildStyle::Ptr bstyle){return bstyle->id == bid;});
+    // The build styles may have been modified through buildStylesRef() since they were indexed
+    if(!mBuildStyleIndexValid) {
+
+        for(auto bstyle : mBuildStyles) {
+            if(bstyle->id == bid)
+                return bstyle;
+        }
 
-    if (result != std::end(mBuildStyles)) {
-        return *result;
-    } else {
         return BuildStyle::Ptr(nullptr);
     }
 
+    auto it = mBuildStyleIndex.find(bid);
+
+    if(it == mBuildStyleIndex.end())
+        return BuildStyle::Ptr(nullptr);
+
+    return mBuildStyles[it->second];
 }
 
 int64_t Model::addBuildStyle(BuildStyle::Ptr bstyle)
@@ -105,12 +135,12 @@ int64_t Model::addBuildStyle(BuildStyle::Ptr bstyle)
     if(!bstyle)
         return -1;
 
-    auto result = std::find_if(std::begin(mBuildStyles), std::end(mBuildStyles),
-                             [&](BuildStyle::Ptr b){return bstyle->id == b->id;});
-
-    if (result != std::end(mBuildStyles))
+    if(this->getBuildStyleById(bstyle->id))
         return -1;
 
+    if(mBuildStyleIndexValid)
+        mBuildStyleIndex.emplace(bstyle->id, mBuildStyles.size());
+
     mBuildStyles.push_back(bstyle);
 
     return mBuildStyles.size();
@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace slm
@@ -120,11 +121,18 @@ public:
     /*
      * Build Style Getters
      */
-     void setBuildStyles(const std::vector<BuildStyle::Ptr> &bstyles) { mBuildStyles = bstyles; }
+     void setBuildStyles(const std::vector<BuildStyle::Ptr> &bstyles);
 
      std::vector<BuildStyle::Ptr> getBuildStyles() const { return mBuildStyles; }
      BuildStyle::Ptr getBuildStyleById(const uint64_t bid) const;
-     std::vector<BuildStyle::Ptr>  & buildStylesRef() { return mBuildStyles; }
+
+     /*
+      * Taking the reference invalidates the index of the build styles by id, after which lookups search the build
+      * styles until reindexBuildStyles() is called. It must be called again after any later change through a held
+      * reference, or after changing the id of a build style.
+      */
+     std::vector<BuildStyle::Ptr>  & buildStylesRef() { mBuildStyleIndexValid = false; return mBuildStyles; }
+     void reindexBuildStyles();
 
     /**
      * Setters
@@ -147,6 +155,10 @@ protected:
     //BStyleMap buildStyles;
 
     std::vector<BuildStyle::Ptr> mBuildStyles;
+
+    // Position of the first build style of each id within mBuildStyles, which is only updated by the setters
+    std::unordered_map<uint64_t, size_t> mBuildStyleIndex;
+    bool mBuildStyleIndexValid;
 };
 
 } // End of SLM Namespace
@@ -0,0 +1,109 @@
+#ifndef SLM_NATIVEFORMAT_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_NATIVEFORMAT_H_HEADER_HAS_BEEN_INCLUDED
+
+#include <cstdint>
+
+namespace slm
+{
+
+/*
+ * The native libSLM binary format is designed to be memory mapped and read without parsing the geometry.
+ *
+ *  [FileHeader]                       - at offset 0, fixed size
+ *  [Metadata]                         - Header and Model/BuildStyle tables
+ *  [LayerRecord] ... [LayerRecord]    - each aligned to Alignment bytes
+ *  [LayerIndex]                       - IndexHeader followed by one IndexEntry per layer record
+ *
+ * Each layer record stores the geometry of the layer as columnar arrays identical to the layout of a GeometryStore,
+ * so that the arrays may be referenced directly within the mapping. Values are stored in the byte order of the
+ * writer, which is recorded in the file header and checked by the reader.
+ */
+namespace native
+{
+
+const char Magic[8] = {'L', 'I', 'B', 'S', 'L', 'M', 'N', 'F'};
+
+const uint32_t Version         = 1;
+const uint32_t ByteOrderMark   = 0x01020304;
+const uint32_t LayerMagic      = 0x5259414c; // 'LAYR'
+const uint32_t IndexMagic      = 0x5844494c; // 'LIDX'
+const uint64_t Alignment       = 64;
+
+inline uint64_t align(uint64_t pos, uint64_t alignment = Alignment)
+{
+    return (pos + alignment - 1) / alignment * alignment;
+}
+
+struct FileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t metadataOffset;
+    uint64_t indexOffset;       // 0 until the build has been finished
+    uint64_t numLayers;
+    double   layerThickness;
+    uint64_t reserved[2];
+};
+
+struct LayerRecordHeader
+{
+    uint32_t magic;
+    uint32_t dim;
+    uint64_t layerId;
+    uint64_t z;
+    uint64_t numGeoms;
+    uint64_t numPoints;
+    uint64_t recordLength;      // Total length of the record including padding
+};
+
+struct IndexHeader
+{
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t numLayers;
+};
+
+struct IndexEntry
+{
+    uint64_t layerId;
+    uint64_t z;
+    uint64_t offset;
+    uint64_t length;
+};
+
+/**
+ * @brief The RecordLayout struct gives the offset of each array relative to the start of a layer record
+ */
+struct RecordLayout
+{
+    RecordLayout(uint64_t numGeoms, uint64_t numPoints, uint32_t dim)
+    {
+        coords        = align(sizeof(LayerRecordHeader));
+        offsets       = align(coords + numPoints * dim * sizeof(float), sizeof(uint64_t));
+        lengths       = offsets + numGeoms * sizeof(uint64_t);
+        modelIds      = lengths + numGeoms * sizeof(uint64_t);
+        buildStyleIds = modelIds + numGeoms * sizeof(uint32_t);
+        types         = buildStyleIds + numGeoms * sizeof(uint32_t);
+        length        = align(types + numGeoms * sizeof(uint8_t));
+    }
+
+    uint64_t coords;
+    uint64_t offsets;
+    uint64_t lengths;
+    uint64_t modelIds;
+    uint64_t buildStyleIds;
+    uint64_t types;
+    uint64_t length;
+};
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader must be 64 bytes");
+static_assert(sizeof(LayerRecordHeader) == 48, "LayerRecordHeader must be 48 bytes");
+static_assert(sizeof(IndexHeader) == 16, "IndexHeader must be 16 bytes");
+static_assert(sizeof(IndexEntry) == 32, "IndexEntry must be 32 bytes");
+
+} // End of Namespace native
+
+} // End of Namespace slm
+
+#endif // SLM_NATIVEFORMAT_H_HEADER_HAS_BEEN_INCLUDED
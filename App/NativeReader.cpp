@@ -0,0 +1,292 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "GeometryStore.h"
+#include "NativeFormat.h"
+#include "NativeReader.h"
+
+using namespace slm;
+
+namespace {
+
+std::string readString(ByteCursor &cursor)
+{
+    const uint32_t len = cursor.read<uint32_t>();
+    return cursor.readString(len);
+}
+
+std::u16string readU16String(ByteCursor &cursor)
+{
+    const uint32_t len = cursor.read<uint32_t>();
+    ByteSpan region = cursor.readSpan(len * sizeof(char16_t));
+
+    std::u16string str(len, u'\0');
+
+    if(len > 0)
+        std::memcpy(&str[0], region.data, region.size);
+
+    return str;
+}
+
+template <class T>
+bool isAligned(const uint8_t *ptr)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignof(T) == 0;
+}
+
+} // End of anonymous namespace
+
+NativeReader::NativeReader(const std::string &fileLoc) : base::Reader(fileLoc),
+                                                         mLayerThickness(0.0),
+                                                         mIndexOffset(0),
+                                                         mNumLayers(0)
+{
+}
+
+NativeReader::NativeReader() : base::Reader(),
+                               mLayerThickness(0.0),
+                               mIndexOffset(0),
+                               mNumLayers(0)
+{
+}
+
+NativeReader::~NativeReader()
+{
+}
+
+bool NativeReader::isNativeFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    char magic[sizeof(native::Magic)];
+
+    if(!file.read(magic, sizeof(magic)))
+        return false;
+
+    return std::memcmp(magic, native::Magic, sizeof(magic)) == 0;
+}
+
+int NativeReader::parse()
+{
+    if(!this->isReady()) {
+        std::cerr << "File '" << filePath << "' is not ready for parsing" << std::endl;
+        return -1;
+    }
+
+    return this->parseIndexed();
+}
+
+int64_t NativeReader::readMetadata(ByteCursor &cursor)
+{
+    native::FileHeader fileHeader;
+
+    const ByteSpan headerData = cursor.readSpan(sizeof(fileHeader));
+    std::memcpy(&fileHeader, headerData.data, sizeof(fileHeader));
+
+    if(std::memcmp(fileHeader.magic, native::Magic, sizeof(native::Magic)) != 0) {
+        std::cerr << "File '" << filePath << "' is not a native libSLM file" << std::endl;
+        return -1;
+    }
+
+    if(fileHeader.byteOrderMark != native::ByteOrderMark) {
+        std::cerr << "File '" << filePath << "' was written with a different byte order" << std::endl;
+        return -1;
+    }
+
+    if(fileHeader.version > native::Version) {
+        std::cerr << "File '" << filePath << "' - unsupported version " << fileHeader.version << std::endl;
+        return -1;
+    }
+
+    mIndexOffset = fileHeader.indexOffset;
+    mNumLayers = fileHeader.numLayers;
+    mLayerThickness = fileHeader.layerThickness;
+
+    cursor.seek(fileHeader.metadataOffset);
+
+    // Header
+    mHeader.fileName = readString(cursor);
+    mHeader.creator = readString(cursor);
+    mHeader.vMajor = cursor.read<int32_t>();
+    mHeader.vMinor = cursor.read<int32_t>();
+    mHeader.zUnit = cursor.read<int32_t>();
+
+    // Model and BuildStyle tables
+    const uint64_t numModels = cursor.read<uint64_t>();
+
+    for(uint64_t i = 0; i < numModels; i++) {
+
+        Model::Ptr model = std::make_shared<Model>();
+        model->setId(cursor.read<uint64_t>());
+        model->setTopSlice(cursor.read<uint64_t>());
+        model->setName(readU16String(cursor));
+        model->setBuildStlyeName(readU16String(cursor));
+        model->setBuildStlyeDescription(readU16String(cursor));
+
+        const uint64_t numStyles = cursor.read<uint64_t>();
+
+        for(uint64_t j = 0; j < numStyles; j++) {
+
+            BuildStyle::Ptr bstyle = std::make_shared<BuildStyle>();
+            bstyle->id = cursor.read<uint64_t>();
+            bstyle->laserId = cursor.read<uint64_t>();
+            bstyle->laserMode = cursor.read<uint64_t>();
+            bstyle->laserPower = cursor.read<float>();
+            bstyle->laserFocus = cursor.read<float>();
+            bstyle->laserSpeed = cursor.read<float>();
+            bstyle->pointDistance = cursor.read<uint64_t>();
+            bstyle->pointDelay = cursor.read<uint64_t>();
+            bstyle->pointExposureTime = cursor.read<uint64_t>();
+            bstyle->jumpSpeed = cursor.read<uint64_t>();
+            bstyle->jumpDelay = cursor.read<uint64_t>();
+            bstyle->setName(readU16String(cursor));
+            bstyle->setDescription(readU16String(cursor));
+
+            model->addBuildStyle(bstyle);
+        }
+
+        models.push_back(model);
+    }
+
+    // The first layer record follows the metadata on the next aligned offset
+    return native::align(cursor.position());
+}
+
+int NativeReader::readLayerIndex(ByteCursor &cursor, std::vector<LayerIndexEntry> &index)
+{
+    // A build which was not finished has no index table, so the layer records are scanned instead
+    if(mIndexOffset == 0)
+        return base::Reader::readLayerIndex(cursor, index);
+
+    ByteCursor indexCursor(cursor.span(), mIndexOffset);
+
+    const uint32_t magic = indexCursor.read<uint32_t>();
+    indexCursor.skip(sizeof(uint32_t));
+    const uint64_t numLayers = indexCursor.read<uint64_t>();
+
+    if(magic != native::IndexMagic || numLayers != mNumLayers) {
+        std::cerr << "File '" << filePath << "' - the layer index is corrupt" << std::endl;
+        return -1;
+    }
+
+    if(!indexCursor.canRead(numLayers * sizeof(native::IndexEntry)))
+        return -1;
+
+    index.reserve(numLayers);
+
+    for(uint64_t i = 0; i < numLayers; i++) {
+
+        LayerIndexEntry entry;
+        entry.layerId = indexCursor.read<uint64_t>();
+        entry.z = indexCursor.read<uint64_t>();
+        entry.offset = indexCursor.read<uint64_t>();
+        entry.length = indexCursor.read<uint64_t>();
+
+        if(entry.offset > cursor.size() || entry.length > cursor.size() - entry.offset)
+            return -1;
+
+        index.push_back(entry);
+    }
+
+    return 1;
+}
+
+int NativeReader::indexLayer(ByteCursor &cursor, LayerIndexEntry &entry)
+{
+    native::LayerRecordHeader record;
+
+    // The end of a file which is still being written may contain an incomplete record
+    if(!cursor.canRead(sizeof(record)))
+        return 0;
+
+    std::memcpy(&record, cursor.current(), sizeof(record));
+
+    if(record.magic == native::IndexMagic)
+        return 0;
+
+    if(record.magic != native::LayerMagic)
+        return -1;
+
+    if(!cursor.canRead(record.recordLength))
+        return 0;
+
+    entry.layerId = record.layerId;
+    entry.z = record.z;
+    entry.offset = cursor.position();
+    entry.length = record.recordLength;
+
+    cursor.skip(record.recordLength);
+
+    return 1;
+}
+
+int NativeReader::decodeLayer(const ByteSpan &record, Layer &layer) const
+{
+    native::LayerRecordHeader recordHeader;
+
+    if(record.size < sizeof(recordHeader))
+        return -1;
+
+    std::memcpy(&recordHeader, record.data, sizeof(recordHeader));
+
+    if(recordHeader.magic != native::LayerMagic || recordHeader.dim == 0)
+        return -1;
+
+    const native::RecordLayout layout(recordHeader.numGeoms, recordHeader.numPoints, recordHeader.dim);
+
+    if(layout.length > record.size)
+        return -1;
+
+    const uint8_t *base = record.data;
+
+    const float    *coords  = reinterpret_cast<const float *>(base + layout.coords);
+    const uint64_t *offsets = reinterpret_cast<const uint64_t *>(base + layout.offsets);
+    const uint64_t *lengths = reinterpret_cast<const uint64_t *>(base + layout.lengths);
+    const uint32_t *mids    = reinterpret_cast<const uint32_t *>(base + layout.modelIds);
+    const uint32_t *bids    = reinterpret_cast<const uint32_t *>(base + layout.buildStyleIds);
+    const uint8_t  *types   = base + layout.types;
+
+    GeometryStore::Ptr store;
+
+    if(isAligned<uint64_t>(base) && this->mappedFile()) {
+
+        // Reference the arrays within the mapping, which is retained by the store
+        store = GeometryStore::wrap(this->mappedFile(), recordHeader.dim, recordHeader.numGeoms,
+                                    recordHeader.numPoints, coords, types, mids, bids, offsets, lengths);
+    } else {
+
+        // The arrays are not suitably aligned in memory, so are copied instead
+        store = std::make_shared<GeometryStore>(recordHeader.dim);
+        store->reserve(recordHeader.numGeoms, recordHeader.numPoints);
+
+        for(uint64_t i = 0; i < recordHeader.numGeoms; i++) {
+
+            uint64_t offset, length;
+            uint32_t mid, bid;
+
+            std::memcpy(&offset, base + layout.offsets + i * sizeof(uint64_t), sizeof(uint64_t));
+            std::memcpy(&length, base + layout.lengths + i * sizeof(uint64_t), sizeof(uint64_t));
+            std::memcpy(&mid, base + layout.modelIds + i * sizeof(uint32_t), sizeof(uint32_t));
+            std::memcpy(&bid, base + layout.buildStyleIds + i * sizeof(uint32_t), sizeof(uint32_t));
+
+            if(offset + length * recordHeader.dim > recordHeader.numPoints * recordHeader.dim)
+                return -1;
+
+            std::vector<float> blockCoords(length * recordHeader.dim);
+
+            if(length > 0)
+                std::memcpy(blockCoords.data(), base + layout.coords + offset * sizeof(float),
+                            blockCoords.size() * sizeof(float));
+
+            store->append(static_cast<LayerGeometry::TYPE>(types[i]), mid, bid, blockCoords.data(), length);
+        }
+    }
+
+    if(!store)
+        return -1;
+
+    layer.setGeometryStore(store);
+
+    return 1;
+}
@@ -0,0 +1,52 @@
+#ifndef SLM_NATIVEREADER_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_NATIVEREADER_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <string>
+
+#include "Header.h"
+#include "Reader.h"
+
+namespace slm
+{
+
+/**
+ * @brief The NativeReader class reads the native libSLM binary format written by NativeWriter.
+ *
+ * The file is memory mapped and the layer index is read from the table at the end of the file. The geometry of each
+ * layer is not copied, but is referenced through a GeometryStore mapped directly onto the layer record, so opening a
+ * build only requires reading the metadata and the index.
+ */
+class SLM_EXPORT NativeReader : public base::Reader
+{
+public:
+    NativeReader(const std::string &buildFile);
+    NativeReader();
+    ~NativeReader();
+
+public:
+    int parse() override;
+    double getLayerThickness() const override { return mLayerThickness; }
+
+    const Header & getHeader() const { return mHeader; }
+
+    // Checks the file signature of a file
+    static bool isNativeFile(const std::string &path);
+
+protected:
+    int64_t readMetadata(ByteCursor &cursor) override;
+    int indexLayer(ByteCursor &cursor, LayerIndexEntry &entry) override;
+    int readLayerIndex(ByteCursor &cursor, std::vector<LayerIndexEntry> &index) override;
+    int decodeLayer(const ByteSpan &record, Layer &layer) const override;
+
+protected:
+    Header mHeader;
+    double mLayerThickness;
+    uint64_t mIndexOffset;
+    uint64_t mNumLayers;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_NATIVEREADER_H_HEADER_HAS_BEEN_INCLUDED
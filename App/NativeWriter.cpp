@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include "NativeFormat.h"
+#include "NativeWriter.h"
+
+using namespace slm;
+
+namespace {
+
+template <class T>
+void writeValue(std::ostream &file, const T &value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void writeString(std::ostream &file, const std::string &str)
+{
+    writeValue<uint32_t>(file, str.size());
+    file.write(str.data(), str.size());
+}
+
+void writeU16String(std::ostream &file, const std::u16string &str)
+{
+    writeValue<uint32_t>(file, str.size());
+    file.write(reinterpret_cast<const char *>(str.data()), str.size() * sizeof(char16_t));
+}
+
+void writePadding(std::ostream &file)
+{
+    const uint64_t pos = static_cast<uint64_t>(file.tellp());
+    const std::vector<char> padding(native::align(pos) - pos, 0);
+
+    file.write(padding.data(), padding.size());
+}
+
+} // End of anonymous namespace
+
+NativeWriter::NativeWriter(const char *fname) : base::Writer(fname),
+                                                mLayerThickness(0.0)
+{
+}
+
+NativeWriter::NativeWriter(const std::string &fname) : base::Writer(fname),
+                                                       mLayerThickness(0.0)
+{
+}
+
+NativeWriter::NativeWriter() : base::Writer(),
+                               mLayerThickness(0.0)
+{
+}
+
+NativeWriter::~NativeWriter()
+{
+}
+
+void NativeWriter::write(const Header &header,
+                         const std::vector<Model::Ptr> &models,
+                         const std::vector<Layer::Ptr> &layers)
+{
+    this->resetTotals();
+    this->setWriteFailed(true);
+
+    std::fstream file;
+    this->getFileHandle(file);
+
+    if(!file.is_open())
+        return;
+
+    if(this->writeMetadata(file, header, models) < 0)
+        return;
+
+    const std::vector<Layer::Ptr> sortedLayers = this->isSortingLayers() ? Writer::sortLayers(layers) : layers;
+
+    if(this->writeLayersParallel(file, sortedLayers) < 0) {
+        std::cerr << "File '" << filePath << "' - failed to write the layers" << std::endl;
+        return;
+    }
+
+    this->setWriteFailed(this->writeIndex(file) < 0);
+}
+
+int NativeWriter::beginStream(const Header &header, const std::vector<Model::Ptr> &models)
+{
+    if(mFile.is_open())
+        mFile.close();
+
+    this->getFileHandle(mFile);
+
+    if(!mFile.is_open())
+        return -1;
+
+    return this->writeMetadata(mFile, header, models);
+}
+
+int NativeWriter::writeStreamLayer(const Layer::Ptr &layer)
+{
+    std::vector<char> buffer;
+
+    if(this->encodeLayer(*layer, buffer) < 0) {
+        std::cerr << "File '" << filePath << "' - failed to encode layer " << layer->getLayerId() << std::endl;
+        return -1;
+    }
+
+    const uint64_t offset = static_cast<uint64_t>(mFile.tellp());
+
+    mFile.write(buffer.data(), buffer.size());
+    this->recordLayerOffset(*layer, offset, buffer.size());
+
+    return mFile.good() ? 1 : -1;
+}
+
+int NativeWriter::finishStream()
+{
+    const int status = this->writeIndex(mFile);
+
+    mFile.close();
+
+    return status;
+}
+
+int NativeWriter::writeMetadata(std::ostream &file, const Header &header, const std::vector<Model::Ptr> &models)
+{
+    // The index offset, layer count and layer thickness are updated once all layers are written
+    native::FileHeader fileHeader;
+    std::memset(&fileHeader, 0, sizeof(fileHeader));
+    std::memcpy(fileHeader.magic, native::Magic, sizeof(native::Magic));
+
+    fileHeader.version = native::Version;
+    fileHeader.byteOrderMark = native::ByteOrderMark;
+    fileHeader.metadataOffset = sizeof(native::FileHeader);
+    fileHeader.layerThickness = mLayerThickness;
+
+    writeValue(file, fileHeader);
+
+    // Header
+    writeString(file, header.fileName);
+    writeString(file, header.creator);
+    writeValue<int32_t>(file, header.vMajor);
+    writeValue<int32_t>(file, header.vMinor);
+    writeValue<int32_t>(file, header.zUnit);
+
+    // Model and BuildStyle tables
+    writeValue<uint64_t>(file, models.size());
+
+    for(auto model : models) {
+
+        writeValue<uint64_t>(file, model->getId());
+        writeValue<uint64_t>(file, model->getTopSlice());
+        writeU16String(file, model->getName());
+        writeU16String(file, model->getBuildStyleName());
+        writeU16String(file, model->getBuildStyleDescription());
+
+        const std::vector<BuildStyle::Ptr> bstyles = model->getBuildStyles();
+        writeValue<uint64_t>(file, bstyles.size());
+
+        for(auto bstyle : bstyles) {
+            writeValue<uint64_t>(file, bstyle->id);
+            writeValue<uint64_t>(file, bstyle->laserId);
+            writeValue<uint64_t>(file, bstyle->laserMode);
+            writeValue<float>(file, bstyle->laserPower);
+            writeValue<float>(file, bstyle->laserFocus);
+            writeValue<float>(file, bstyle->laserSpeed);
+            writeValue<uint64_t>(file, bstyle->pointDistance);
+            writeValue<uint64_t>(file, bstyle->pointDelay);
+            writeValue<uint64_t>(file, bstyle->pointExposureTime);
+            writeValue<uint64_t>(file, bstyle->jumpSpeed);
+            writeValue<uint64_t>(file, bstyle->jumpDelay);
+            writeU16String(file, bstyle->name);
+            writeU16String(file, bstyle->description);
+        }
+    }
+
+    // Layer records begin on an aligned offset
+    writePadding(file);
+
+    return file.good() ? 1 : -1;
+}
+
+int NativeWriter::writeIndex(std::ostream &file)
+{
+    const std::vector<LayerIndexEntry> &layerOffsets = this->totals().layerOffsets;
+
+    writePadding(file);
+
+    const uint64_t indexOffset = static_cast<uint64_t>(file.tellp());
+
+    native::IndexHeader indexHeader;
+    indexHeader.magic = native::IndexMagic;
+    indexHeader.reserved = 0;
+    indexHeader.numLayers = layerOffsets.size();
+
+    writeValue(file, indexHeader);
+
+    std::vector<uint64_t> zPositions;
+    zPositions.reserve(layerOffsets.size());
+
+    for(const LayerIndexEntry &layerEntry : layerOffsets) {
+
+        native::IndexEntry entry;
+        entry.layerId = layerEntry.layerId;
+        entry.z = layerEntry.z;
+        entry.offset = layerEntry.offset;
+        entry.length = layerEntry.length;
+
+        writeValue(file, entry);
+
+        zPositions.push_back(layerEntry.z);
+    }
+
+    // Estimate the layer thickness from the smallest spacing between layers when not provided
+    double layerThickness = mLayerThickness;
+
+    if(layerThickness <= 0.0) {
+
+        std::sort(zPositions.begin(), zPositions.end());
+
+        for(size_t i = 1; i < zPositions.size(); i++) {
+
+            const double dz = zPositions[i] - zPositions[i - 1];
+
+            if(dz > 0.0 && (layerThickness <= 0.0 || dz < layerThickness))
+                layerThickness = dz;
+        }
+    }
+
+    Writer::patchValue<uint64_t>(file, offsetof(native::FileHeader, indexOffset), indexOffset);
+    Writer::patchValue<uint64_t>(file, offsetof(native::FileHeader, numLayers), layerOffsets.size());
+    Writer::patchValue<double>(file, offsetof(native::FileHeader, layerThickness), layerThickness);
+
+    file.flush();
+
+    return file.good() ? 1 : -1;
+}
+
+int NativeWriter::encodeLayer(const Layer &layer, std::vector<char> &buffer) const
+{
+    const uint32_t dim = 2;
+
+    const GeometryViewRange views = layer.geometryViews();
+
+    uint64_t numPoints = 0;
+
+    for(auto geom : views) {
+
+        // All geometry within the file share the same dimension
+        if(geom.rows > 0 && geom.cols != dim)
+            return -1;
+
+        numPoints += geom.rows;
+    }
+
+    const uint64_t numGeoms = views.size();
+    const native::RecordLayout layout(numGeoms, numPoints, dim);
+
+    buffer.assign(layout.length, 0);
+    char *base = buffer.data();
+
+    native::LayerRecordHeader recordHeader;
+    recordHeader.magic = native::LayerMagic;
+    recordHeader.dim = dim;
+    recordHeader.layerId = layer.getLayerId();
+    recordHeader.z = layer.getZ();
+    recordHeader.numGeoms = numGeoms;
+    recordHeader.numPoints = numPoints;
+    recordHeader.recordLength = layout.length;
+
+    std::memcpy(base, &recordHeader, sizeof(recordHeader));
+
+    uint64_t offset = 0;
+    size_t i = 0;
+
+    for(auto geom : views) {
+
+        const uint64_t length = geom.rows;
+        const uint32_t mid = geom.mid;
+        const uint32_t bid = geom.bid;
+        const uint8_t type = static_cast<uint8_t>(geom.type);
+
+        // Coordinates are stored column-major per block, matching LayerGeometry::coords
+        if(length > 0)
+            std::memcpy(base + layout.coords + offset * sizeof(float), geom.data, length * dim * sizeof(float));
+
+        std::memcpy(base + layout.offsets + i * sizeof(uint64_t), &offset, sizeof(uint64_t));
+        std::memcpy(base + layout.lengths + i * sizeof(uint64_t), &length, sizeof(uint64_t));
+        std::memcpy(base + layout.modelIds + i * sizeof(uint32_t), &mid, sizeof(uint32_t));
+        std::memcpy(base + layout.buildStyleIds + i * sizeof(uint32_t), &bid, sizeof(uint32_t));
+        std::memcpy(base + layout.types + i, &type, sizeof(uint8_t));
+
+        offset += length * dim;
+        i++;
+    }
+
+    return 1;
+}
@@ -0,0 +1,56 @@
+#ifndef SLM_NATIVEWRITER_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_NATIVEWRITER_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <fstream>
+#include <string>
+
+#include "Writer.h"
+
+namespace slm
+{
+
+/**
+ * @brief The NativeWriter class writes a build in the native libSLM binary format, which may be memory mapped and
+ * opened by NativeReader without parsing. Layers are encoded concurrently when written with write() and may also be
+ * written incrementally using begin(), appendLayer() and finish().
+ */
+class SLM_EXPORT NativeWriter : public base::Writer
+{
+public:
+    NativeWriter(const char *fileLoc);
+    NativeWriter(const std::string &fileLoc);
+    NativeWriter();
+    ~NativeWriter();
+
+public:
+    void write(const Header &header,
+               const std::vector<Model::Ptr> &models,
+               const std::vector<Layer::Ptr> &layers) override;
+
+    /*
+     * The layer thickness stored in the file. When not set, it is taken as the smallest spacing between the z
+     * positions of the layers written.
+     */
+    void setLayerThickness(double val) { mLayerThickness = val; }
+    double getLayerThickness() const { return mLayerThickness; }
+
+protected:
+    int beginStream(const Header &header, const std::vector<Model::Ptr> &models) override;
+    int writeStreamLayer(const Layer::Ptr &layer) override;
+    int finishStream() override;
+
+    int encodeLayer(const Layer &layer, std::vector<char> &buffer) const override;
+
+    int writeMetadata(std::ostream &file, const Header &header, const std::vector<Model::Ptr> &models);
+    int writeIndex(std::ostream &file);
+
+protected:
+    std::fstream mFile;
+    double mLayerThickness;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_NATIVEWRITER_H_HEADER_HAS_BEEN_INCLUDED
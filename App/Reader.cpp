@@ -1,14 +1,20 @@
 #include <algorithm>
+#include <atomic>
 #include <iostream>
-#include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 #include <filesystem/fwd.h>
 #include <filesystem/resolver.h>
 #include <filesystem/path.h>
 
 
+#include "Build.h"
+#include "GeometryStore.h"
 #include "Layer.h"
 #include "Model.h"
+#include "ThreadPool.h"
 
 #include "Reader.h"
 
@@ -17,21 +23,250 @@ using namespace base;
 
 namespace fs = filesystem;
 
-Reader::Reader(const std::string &fileLoc) : ready(false)
+namespace slm {
+namespace base {
+
+/**
+ * Loads the layers of a Reader on demand, keeping the loaded layers within the memory budget of the reader
+ */
+class LazyLayerLoader : public LayerLoader
+{
+public:
+    LazyLayerLoader(const Reader *reader) : mReader(reader), mLoadedBytes(0) {}
+
+    void addLayer(const Layer *layer, size_t idx)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        mIndex[layer] = idx;
+    }
+
+    void load(Layer &layer) override
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+        auto it = mIndex.find(&layer);
+
+        if(!mReader || it == mIndex.end() || layer.isLoaded())
+            return;
+
+        // Mark as loaded beforehand so that the geometry may be accessed whilst it is decoded
+        layer.setIsLoaded(true);
+
+        if(mReader->decodeIndexedLayer(it->second, layer) < 0) {
+            layer.clear();
+            return;
+        }
+
+        const uint64_t bytes = layer.memoryUsage();
+
+        mLru.push_front(Entry(&layer, bytes));
+        mLruPos[&layer] = mLru.begin();
+        mLoadedBytes += bytes;
+
+        this->evict();
+    }
+
+    void access(Layer &layer) override
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+        // The layer may have been evicted whilst waiting for the lock
+        if(!layer.isLoaded()) {
+            this->load(layer);
+            return;
+        }
+
+        auto it = mLruPos.find(&layer);
+
+        if(it != mLruPos.end())
+            mLru.splice(mLru.begin(), mLru, it->second);
+    }
+
+    void release(Layer &layer) override
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+        this->remove(&layer);
+        mIndex.erase(&layer);
+    }
+
+    void evict()
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+        const uint64_t budget = mReader ? mReader->memoryBudget() : 0;
+
+        /*
+         * The least recently used layers are evicted first. The most recently loaded layer is always retained,
+         * whilst pinned layers are retained until a later load once they are no longer pinned.
+         */
+        auto it = mLru.end();
+
+        while(budget > 0 && mLoadedBytes > budget && it != mLru.begin()) {
+
+            Layer *layer = (--it)->first;
+
+            if(it == mLru.begin() || !layer->unload())
+                continue;
+
+            ++it;
+            this->remove(layer);
+        }
+    }
+
+    void detach()
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        mReader = nullptr;
+    }
+
+    uint64_t loadedBytes() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        return mLoadedBytes;
+    }
+
+private:
+    typedef std::pair<Layer *, uint64_t> Entry;
+
+    void remove(const Layer *layer)
+    {
+        auto it = mLruPos.find(layer);
+
+        if(it == mLruPos.end())
+            return;
+
+        mLoadedBytes -= it->second->second;
+        mLru.erase(it->second);
+        mLruPos.erase(it);
+    }
+
+    const Reader *mReader;
+    uint64_t mLoadedBytes;
+
+    std::unordered_map<const Layer *, size_t> mIndex;
+    std::list<Entry> mLru;
+    std::unordered_map<const Layer *, std::list<Entry>::iterator> mLruPos;
+
+    mutable std::recursive_mutex mMutex;
+};
+
+} // End of Namespace base
+} // End of Namespace slm
+
+namespace {
+
+// Removes the geometry of the layer which does not belong to the models selected by the filter
+void filterLayerModels(Layer &layer, const LayerFilter &filter)
+{
+    if(!filter.hasModelFilter())
+        return;
+
+    if(!layer.hasGeometryStore()) {
+        std::vector<LayerGeometry::Ptr> &geoms = layer.geometryRef();
+
+        geoms.erase(std::remove_if(geoms.begin(), geoms.end(), [&filter](const LayerGeometry::Ptr &geom) {
+            return !filter.matchesModel(geom->mid);
+        }), geoms.end());
+
+        layer.invalidateIndex();
+        return;
+    }
+
+    const GeometryStore::Ptr source = layer.geometryStore();
+    GeometryStore::Ptr store = std::make_shared<GeometryStore>(source->dimension());
+
+    for(auto geom : layer.geometryViews()) {
+        if(filter.matchesModel(geom.mid))
+            store->append(geom);
+    }
+
+    if(store->size() != layer.numGeometry())
+        layer.setGeometryStore(store);
+}
+
+} // End of anonymous namespace
+
+Reader::Reader(const std::string &fileLoc) : mLayerSectionOffset(-1),
+                                             mNextLayerOffset(-1),
+                                             mNumThreads(0),
+                                             mLazyLoading(false),
+                                             mMemoryBudget(0),
+                                             ready(false)
 {
     setFilePath(fileLoc);
 }
 
-Reader::Reader() : ready(false)
+Reader::Reader() : mLayerSectionOffset(-1),
+                   mNextLayerOffset(-1),
+                   mNumThreads(0),
+                   mLazyLoading(false),
+                   mMemoryBudget(0),
+                   ready(false)
 {
 }
 
 Reader::~Reader()
 {
+    this->stopPrefetch();
+
+    // Layers may outlive the reader, but can no longer be loaded
+    if(mLazyLoader)
+        mLazyLoader->detach();
+
     models.clear();
     layers.clear();
 }
 
+void Reader::setMemoryBudget(uint64_t bytes)
+{
+    mMemoryBudget = bytes;
+
+    if(mLazyLoader)
+        mLazyLoader->evict();
+}
+
+uint64_t Reader::loadedMemory() const
+{
+    if(mLazyLoader)
+        return mLazyLoader->loadedBytes();
+
+    uint64_t bytes = 0;
+
+    for(auto layer : layers)
+        bytes += layer->memoryUsage();
+
+    return bytes;
+}
+
+int Reader::mapFile()
+{
+    if(!this->isReady()) {
+        std::cerr << "File is not ready for parsing";
+        return -1;
+    }
+
+    // Re-use an existing mapping of the same file
+    if(mFile && mFile->filePath() == this->filePath)
+        return 1;
+
+    MappedFile::Ptr file = std::make_shared<MappedFile>();
+
+    if(!file->open(this->filePath)) {
+        std::cerr << "File '" << filePath << "' could not be open for reading";
+        return -1;
+    }
+
+    mFile = file;
+
+    return 1;
+}
+
+void Reader::unmapFile()
+{
+    mFile.reset();
+}
+
 int64_t Reader::getFileSize() const
 {
 
@@ -80,53 +315,562 @@ Model::Ptr Reader::getModelById(uint64_t mid) const
 
 Layer::Ptr Reader::getTopLayerByPosition(const std::vector<Layer::Ptr> &layers)
 {
-    uint64_t zMax = 0;
+    return Build::getTopLayerByPosition(layers);
+}
+
+Layer::Ptr Reader::getTopLayerById(const std::vector<Layer::Ptr> &layers)
+{
+    return Build::getTopLayerById(layers);
+}
+
+
+int Reader::parse()
+{
+    // Subclasses read the mapped file through fileData() or fileCursor()
+    return this->mapFile();
+}
+
+int64_t Reader::readMetadata(ByteCursor &cursor)
+{
+    return -1;
+}
+
+int Reader::indexLayer(ByteCursor &cursor, LayerIndexEntry &entry)
+{
+    return -1;
+}
+
+int Reader::decodeLayer(const ByteSpan &record, Layer &layer) const
+{
+    return -1;
+}
+
+int Reader::readLayerIndex(ByteCursor &cursor, std::vector<LayerIndexEntry> &index)
+{
+    LayerIndexEntry entry;
+    int status;
+
+    while((status = this->indexLayer(cursor, entry)) > 0)
+        index.push_back(entry);
+
+    return status < 0 ? -1 : 1;
+}
+
+int Reader::buildLayerIndex()
+{
+    // The prefetch thread decodes from the index and mapping, so is stopped before either is replaced
+    this->stopPrefetch();
+
+    if(this->mapFile() < 0)
+        return -1;
+
+    mLayerIndex.clear();
+
+    try {
+        ByteCursor cursor = this->fileCursor();
+
+        models.clear();
+        mLayerSectionOffset = this->readMetadata(cursor);
 
-    Layer::Ptr fndLayer;
+        if(mLayerSectionOffset < 0) {
+            std::cerr << "File '" << filePath << "' - failed to read the header" << std::endl;
+            return -1;
+        }
 
-    for(auto layer : layers) {
+        cursor.seek(mLayerSectionOffset);
 
-        if(layer->getZ() > zMax) {
-            fndLayer = layer;
-            zMax = layer->getZ();
+        if(this->readLayerIndex(cursor, mLayerIndex) < 0) {
+            std::cerr << "File '" << filePath << "' - failed to index the layers" << std::endl;
+            return -1;
         }
+
+    } catch(const std::exception &e) {
+        std::cerr << "File '" << filePath << "' - " << e.what() << std::endl;
+        return -1;
     }
 
-    return fndLayer;
+    // Layers appended to the file later are located from the end of the last layer record
+    mNextLayerOffset = mLayerSectionOffset;
+
+    for(const LayerIndexEntry &entry : mLayerIndex)
+        mNextLayerOffset = std::max<int64_t>(mNextLayerOffset, entry.offset + entry.length);
+
+    return 1;
 }
 
-Layer::Ptr Reader::getTopLayerById(const std::vector<Layer::Ptr> &layers)
+int Reader::decodeIndexedLayer(size_t idx, Layer &layer) const
+{
+    return this->decodeLayerEntry(mLayerIndex.at(idx), layer);
+}
+
+int Reader::decodeLayerEntry(const LayerIndexEntry &entry, Layer &layer) const
+{
+    layer.setLayerId(entry.layerId);
+    layer.setZ(entry.z);
+    layer.setLayerFilePosition(entry.offset);
+
+    try {
+        if(this->decodeLayer(this->fileData().subspan(entry.offset, entry.length), layer) < 0)
+            return -1;
+    } catch(const std::exception &e) {
+        std::cerr << "File '" << filePath << "' - layer " << entry.layerId << " - " << e.what() << std::endl;
+        return -1;
+    }
+
+    layer.setIsLoaded(true);
+
+    return 1;
+}
+
+int Reader::parseIndexed()
+{
+    this->stopPrefetch();
+    mFilter.reset();
+
+    if(mLazyLoader) {
+        mLazyLoader->detach();
+        mLazyLoader.reset();
+    }
+
+    if(this->buildLayerIndex() < 0)
+        return -1;
+
+    const size_t numLayers = mLayerIndex.size();
+
+    if(mLazyLoading) {
+        this->createUnloadedLayers();
+        return 1;
+    }
+
+    // Each layer is decoded into its own slot so that the order of the file is retained
+    layers.assign(numLayers, Layer::Ptr());
+
+    std::atomic<int> numFailed(0);
+
+    ThreadPool::instance().parallelFor(numLayers, [&](size_t begin, size_t end) {
+
+        for(size_t i = begin; i < end; i++) {
+
+            Layer::Ptr layer = std::make_shared<Layer>();
+
+            if(this->decodeIndexedLayer(i, *layer) < 0)
+                numFailed++;
+
+            layers[i] = layer;
+        }
+
+    }, 0, mNumThreads > 0 ? mNumThreads : 0);
+
+    return numFailed > 0 ? -1 : 1;
+}
+
+void Reader::createUnloadedLayers()
+{
+    // Only create the layers, which are decoded by the loader when first accessed
+    mLazyLoader = std::make_shared<LazyLayerLoader>(this);
+
+    layers.clear();
+    layers.reserve(mLayerIndex.size());
+
+    for(size_t i = 0; i < mLayerIndex.size(); i++)
+        this->appendUnloadedLayer(i);
+}
+
+void Reader::appendUnloadedLayer(size_t idx)
 {
-    uint64_t zId = 0;
+    const LayerIndexEntry &entry = mLayerIndex[idx];
+
+    Layer::Ptr layer = std::make_shared<Layer>(entry.layerId, entry.z);
+    layer->setLayerFilePosition(entry.offset);
+    layer->setLoader(mLazyLoader);
+
+    mLazyLoader->addLayer(layer.get(), idx);
+    layers.push_back(layer);
+}
+
+int64_t Reader::refresh()
+{
+    // The file may have grown since it was mapped. Layers referencing the previous mapping retain it.
+    this->stopPrefetch();
+    this->unmapFile();
+
+    if(this->mapFile() < 0)
+        return -1;
 
-    Layer::Ptr fndLayer;
+    ByteCursor cursor = this->fileCursor();
 
-    for(auto layer : layers) {
+    if(mNextLayerOffset < 0) {
 
-        if(layer->getLayerId() > zId) {
-            fndLayer = layer;
-            zId = layer->getLayerId();
+        int64_t layerSectionOffset;
+
+        try {
+            models.clear();
+            layerSectionOffset = this->readMetadata(cursor);
+        } catch(const std::out_of_range &e) {
+            // The header has not been completely written yet
+            models.clear();
+            return 0;
+        }
+
+        if(layerSectionOffset < 0) {
+            std::cerr << "File '" << filePath << "' - failed to read the header" << std::endl;
+            return -1;
+        }
+
+        if(mLazyLoader) {
+            mLazyLoader->detach();
+            mLazyLoader.reset();
         }
+
+        mLayerIndex.clear();
+        layers.clear();
+
+        mLayerSectionOffset = layerSectionOffset;
+        mNextLayerOffset = layerSectionOffset;
     }
 
-    return fndLayer;
+    // Only the complete layer records written since the previous refresh are indexed
+    const size_t first = mLayerIndex.size();
+
+    LayerIndexEntry entry;
+    int status = 0;
+
+    try {
+        cursor.seek(mNextLayerOffset);
+
+        while((status = this->indexLayer(cursor, entry)) > 0) {
+            mLayerIndex.push_back(entry);
+            mNextLayerOffset = cursor.position();
+        }
+    } catch(const std::out_of_range &e) {
+        // A partially written record ends the layers available
+        status = 0;
+    }
+
+    if(status < 0) {
+        std::cerr << "File '" << filePath << "' - failed to index the layers" << std::endl;
+        return -1;
+    }
+
+    // The layers of a filtered build are always decoded, as the filter is applied to their geometry
+    if(mLazyLoading && !mFilter) {
+
+        if(!mLazyLoader)
+            mLazyLoader = std::make_shared<LazyLayerLoader>(this);
+
+        for(size_t i = first; i < mLayerIndex.size(); i++)
+            this->appendUnloadedLayer(i);
+
+        return mLayerIndex.size() - first;
+    }
+
+    // The index covers every layer of the file, whereas the layers may be only those selected by parseFiltered
+    std::vector<size_t> selected;
+
+    for(size_t i = first; i < mLayerIndex.size(); i++) {
+        if(!mFilter || mFilter->matchesLayer(mLayerIndex[i].layerId, mLayerIndex[i].z))
+            selected.push_back(i);
+    }
+
+    const size_t firstSlot = layers.size();
+    layers.resize(firstSlot + selected.size());
+
+    std::atomic<int> numFailed(0);
+
+    ThreadPool::instance().parallelFor(selected.size(), [&](size_t begin, size_t end) {
+
+        for(size_t i = begin; i < end; i++) {
+
+            Layer::Ptr layer = std::make_shared<Layer>();
+
+            if(this->decodeIndexedLayer(selected[i], *layer) < 0)
+                numFailed++;
+            else if(mFilter)
+                filterLayerModels(*layer, *mFilter);
+
+            layers[firstSlot + i] = layer;
+        }
+
+    }, 0, mNumThreads > 0 ? mNumThreads : 0);
+
+    return numFailed > 0 ? -1 : static_cast<int64_t>(selected.size());
 }
 
+bool Reader::supportsIndexing()
+{
+    bool hasMetadata = false;
 
-int Reader::parse()
+    try {
+        ByteCursor cursor = this->fileCursor();
+        hasMetadata = this->readMetadata(cursor) >= 0;
+    } catch(const std::exception &e) {
+        hasMetadata = false;
+    }
+
+    // The metadata is read again when the build is indexed or parsed
+    models.clear();
+
+    return hasMetadata;
+}
+
+int Reader::parseMetadata()
 {
-    if(!this->isReady()) {
-        std::cerr << "File is not ready for parsing";
+    this->stopPrefetch();
+    mFilter.reset();
+
+    if(mLazyLoader) {
+        mLazyLoader->detach();
+        mLazyLoader.reset();
+    }
+
+    mLayerIndex.clear();
+
+    if(this->mapFile() < 0)
+        return -1;
+
+    // Readers without support for indexing can only provide the metadata by parsing the entire build
+    if(!this->supportsIndexing())
+        return this->parse();
+
+    if(this->buildLayerIndex() < 0)
         return -1;
+
+    this->createUnloadedLayers();
+
+    return 1;
+}
+
+int Reader::parseFiltered(const LayerFilter &filter)
+{
+    this->stopPrefetch();
+    mFilter.reset();
+
+    if(mLazyLoader) {
+        mLazyLoader->detach();
+        mLazyLoader.reset();
     }
 
-    std::ifstream file;
-    file.open(this->filePath, std::ifstream::binary);
-    if(!file.is_open()) {
-        std::cerr << "File '" << filePath << "' could not be open for reading";
+    mLayerIndex.clear();
+
+    if(this->mapFile() < 0)
         return -1;
+
+    // Readers without support for indexing parse the entire build, after which the layers are filtered
+    if(!this->supportsIndexing()) {
+
+        if(this->parse() < 0)
+            return -1;
+
+        std::vector<Layer::Ptr> selected;
+
+        for(auto layer : layers) {
+            if(filter.matchesLayer(layer->getLayerId(), layer->getZ())) {
+                filterLayerModels(*layer, filter);
+                selected.push_back(layer);
+            }
+        }
+
+        layers.swap(selected);
+
+        return 1;
     }
 
-    file.close();
+    if(this->buildLayerIndex() < 0)
+        return -1;
+
+    // The filter is retained to select the layers appended by refresh()
+    mFilter.reset(new LayerFilter(filter));
+
+    std::vector<size_t> selected;
+
+    for(size_t i = 0; i < mLayerIndex.size(); i++) {
+        if(filter.matchesLayer(mLayerIndex[i].layerId, mLayerIndex[i].z))
+            selected.push_back(i);
+    }
+
+    layers.assign(selected.size(), Layer::Ptr());
+
+    std::atomic<int> numFailed(0);
+
+    ThreadPool::instance().parallelFor(selected.size(), [&](size_t begin, size_t end) {
+
+        for(size_t i = begin; i < end; i++) {
+
+            Layer::Ptr layer = std::make_shared<Layer>();
+
+            if(this->decodeIndexedLayer(selected[i], *layer) < 0)
+                numFailed++;
+            else
+                filterLayerModels(*layer, filter);
+
+            layers[i] = layer;
+        }
+
+    }, 0, mNumThreads > 0 ? mNumThreads : 0);
+
+    return numFailed > 0 ? -1 : 1;
+}
+
+int Reader::startPrefetch(size_t depth)
+{
+    this->stopPrefetch();
+    mFilter.reset();
+
+    if(this->mapFile() < 0)
+        return -1;
+
+    if(!this->supportsIndexing()) {
+
+        if(this->parse() < 0)
+            return -1;
+
+        // The layers are already decoded, so are only passed through the queue
+        std::vector<Layer::Ptr> parsedLayers;
+        parsedLayers.swap(layers);
+
+        mPrefetcher.reset(new LayerPrefetcher(parsedLayers.size(), [parsedLayers](size_t idx) {
+            return parsedLayers[idx];
+        }, depth));
+
+        return 1;
+    }
+
+    if(this->buildLayerIndex() < 0)
+        return -1;
+
+    // The prefetched layers are not retained, so a later refresh() reads the build from the start
+    mNextLayerOffset = -1;
+
+    mPrefetcher.reset(new LayerPrefetcher(mLayerIndex.size(), [this](size_t idx) {
+
+        Layer::Ptr layer = std::make_shared<Layer>();
+
+        if(this->decodeIndexedLayer(idx, *layer) < 0)
+            return Layer::Ptr();
+
+        return layer;
+
+    }, depth));
+
     return 1;
 }
+
+Layer::Ptr Reader::nextLayer()
+{
+    return mPrefetcher ? mPrefetcher->next() : Layer::Ptr();
+}
+
+void Reader::stopPrefetch()
+{
+    if(mPrefetcher) {
+        mPrefetcher->stop();
+        mPrefetcher.reset();
+    }
+}
+
+bool Reader::hasPrefetchFailed() const
+{
+    return mPrefetcher && mPrefetcher->hasFailed();
+}
+
+PrefetchStats Reader::prefetchStats() const
+{
+    return mPrefetcher ? mPrefetcher->stats() : PrefetchStats();
+}
+
+BuildSummary Reader::getSummary() const
+{
+    BuildSummary summary;
+    summary.numModels = models.size();
+    summary.layerThickness = this->getLayerThickness();
+
+    bool first = true;
+
+    auto addLayer = [&](uint64_t layerId, uint64_t z) {
+        summary.zMin = first ? z : std::min(summary.zMin, z);
+        summary.zMax = first ? z : std::max(summary.zMax, z);
+        summary.topLayerId = first ? layerId : std::max(summary.topLayerId, layerId);
+        summary.numLayers++;
+        first = false;
+    };
+
+    if(!mLayerIndex.empty()) {
+        for(const LayerIndexEntry &entry : mLayerIndex)
+            addLayer(entry.layerId, entry.z);
+    } else {
+        for(auto layer : layers)
+            addLayer(layer->getLayerId(), layer->getZ());
+    }
+
+    return summary;
+}
+
+int64_t Reader::visitLayers(const LayerVisitor &visitor)
+{
+    this->stopPrefetch();
+
+    if(this->mapFile() < 0)
+        return -1;
+
+    // The Model table is read into a separate table, so that a build already parsed by the reader is unchanged
+    std::vector<Model::Ptr> parsedModels;
+    std::vector<Model::Ptr> visitModels;
+    int64_t layerSectionOffset;
+
+    ByteCursor cursor = this->fileCursor();
+
+    models.swap(parsedModels);
+
+    try {
+        layerSectionOffset = this->readMetadata(cursor);
+
+        if(layerSectionOffset >= 0)
+            cursor.seek(layerSectionOffset);
+
+    } catch(const std::out_of_range &e) {
+        layerSectionOffset = -1;
+    }
+
+    visitModels.swap(models);
+    models.swap(parsedModels);
+
+    if(layerSectionOffset < 0) {
+        std::cerr << "File '" << filePath << "' - failed to read the header" << std::endl;
+        return -1;
+    }
+
+    int64_t numVisited = 0;
+    LayerIndexEntry entry;
+    int status = 0;
+
+    // Only reading the file is guarded, so that exceptions thrown by the visitor are propagated to the caller
+    while(true) {
+
+        try {
+            status = this->indexLayer(cursor, entry);
+        } catch(const std::out_of_range &e) {
+            std::cerr << "File '" << filePath << "' - " << e.what() << std::endl;
+            return -1;
+        }
+
+        if(status <= 0)
+            break;
+
+        Layer::Ptr layer = std::make_shared<Layer>();
+
+        if(this->decodeLayerEntry(entry, *layer) < 0)
+            return -1;
+
+        numVisited++;
+
+        if(!visitor(layer, visitModels))
+            break;
+    }
+
+    if(status < 0) {
+        std::cerr << "File '" << filePath << "' - failed to index the layers" << std::endl;
+        return -1;
+    }
+
+    return numVisited;
+}
@@ -3,20 +3,79 @@
 
 #include "SLM_Export.h"
 
+#include <functional>
+#include <limits>
+#include <set>
 #include <string>
 
 #include "Layer.h"
+#include "LayerPrefetcher.h"
+#include "MappedFile.h"
 #include "Model.h"
 
 namespace slm
 {
 
+/**
+ * @brief The BuildSummary struct holds the summary of a build which is available without decoding its geometry
+ */
+struct BuildSummary
+{
+    uint64_t numLayers  = 0;
+    uint64_t numModels  = 0;
+    uint64_t zMin       = 0;
+    uint64_t zMax       = 0;
+    uint64_t topLayerId = 0;
+    double layerThickness = 0.0;
+};
+
+/**
+ * @brief The LayerFilter struct selects the layers and geometry decoded by Reader::parseFiltered. The layer id and
+ * z intervals are inclusive, and an empty set of model ids selects the geometry of every model.
+ */
+struct LayerFilter
+{
+    uint64_t layerIdMin = 0;
+    uint64_t layerIdMax = std::numeric_limits<uint64_t>::max();
+    uint64_t zMin = 0;
+    uint64_t zMax = std::numeric_limits<uint64_t>::max();
+    std::set<uint64_t> modelIds;
+
+    void setLayerIdRange(uint64_t first, uint64_t last) { layerIdMin = first; layerIdMax = last; }
+    void setZRange(uint64_t first, uint64_t last) { zMin = first; zMax = last; }
+    void addModel(uint64_t mid) { modelIds.insert(mid); }
+
+    bool hasModelFilter() const { return !modelIds.empty(); }
+
+    bool matchesLayer(uint64_t layerId, uint64_t z) const
+    {
+        return layerId >= layerIdMin && layerId <= layerIdMax && z >= zMin && z <= zMax;
+    }
+
+    bool matchesModel(uint64_t mid) const
+    {
+        return modelIds.empty() || modelIds.count(mid) > 0;
+    }
+};
+
 namespace base
 {
 
+class LazyLayerLoader;
+
 class SLM_EXPORT Reader
 {
+    friend class LazyLayerLoader;
+
 public:
+    typedef std::shared_ptr<Reader> Ptr;
+
+    /**
+     * Callback receiving each decoded layer in sequence with the Model table of the build.
+     * Returning false stops reading further layers.
+     */
+    typedef std::function<bool(const Layer::Ptr &layer, const std::vector<Model::Ptr> &models)> LayerVisitor;
+
     Reader(const std::string &buildFile);
     Reader();
     virtual ~Reader();
@@ -30,6 +89,33 @@ public:
     int64_t getFileSize() const;
 
     virtual double getLayerThickness() const = 0;
+
+    /**
+     * Reads only the Model tables and the layer index of the build, skipping the geometry of the layers. The layers
+     * are created without their geometry, which is decoded upon first access. Readers which do not implement
+     * readMetadata, indexLayer and decodeLayer fall back to a full parse().
+     */
+    int parseMetadata();
+
+    // Summary of the build from the layer index, or from the layers when the build was not indexed
+    BuildSummary getSummary() const;
+
+    /**
+     * Parses only the layers within the layer id and z intervals of the filter, and only retains the geometry of
+     * the models selected. The records of other layers are skipped using the layer index, without being decoded.
+     * Readers which do not implement readMetadata, indexLayer and decodeLayer parse the entire build and filter the
+     * layers afterwards.
+     */
+    int parseFiltered(const LayerFilter &filter);
+
+    /**
+     * Incrementally parses a build which is still being written. Each call decodes only the complete layer records
+     * appended to the file since the previous call, or since the build was parsed, and appends them to the layers.
+     * A partially written layer record is decoded by a later call once complete. After parseFiltered() only the
+     * appended layers selected by the filter are added. After startPrefetch() the build is read from the start.
+     * @return The number of layers added or -1 on failure
+     */
+    int64_t refresh();
     
     Model::Ptr getModelById(uint64_t mid) const;
     std::vector<Model::Ptr> getModels() const { return models;}
@@ -38,16 +124,120 @@ public:
     Layer::Ptr getTopLayerByPosition(const std::vector<Layer::Ptr> &layers);
     Layer::Ptr getTopLayerById(const std::vector<Layer::Ptr> &layers);
 
+    // Number of threads used for decoding layers, 0 uses all available threads
+    void setNumThreads(int num) { mNumThreads = num; }
+    int numThreads() const { return mNumThreads; }
+
+    const std::vector<LayerIndexEntry> & layerIndex() const { return mLayerIndex; }
+
+    /**
+     * Streams the build through the visitor one layer at a time, without storing the layers. Each layer is released
+     * after the visitor returns unless it is retained by the visitor, so the build is processed in constant memory.
+     * The visitor receives its own Model table, and any build already parsed by the reader is left unchanged.
+     * Exceptions thrown by the visitor are propagated. Requires the reader to implement readMetadata, indexLayer
+     * and decodeLayer.
+     * @return The number of layers visited or -1 on failure
+     */
+    int64_t visitLayers(const LayerVisitor &visitor);
+
+    /*
+     * Sequential read-ahead. startPrefetch() indexes the build and decodes the layers in order on a background
+     * thread, staying up to depth layers ahead of the consumer, which retrieves each layer with nextLayer(). As with
+     * visitLayers, the layers are not retained by the reader. Readers which do not implement readMetadata,
+     * indexLayer and decodeLayer parse the entire build beforehand. nextLayer() returns a null pointer both at the
+     * end of the build and once a layer fails to decode, which are distinguished by hasPrefetchFailed(). Parsing or
+     * refreshing the reader stops the prefetch.
+     */
+    int startPrefetch(size_t depth = 8);
+    Layer::Ptr nextLayer();
+    void stopPrefetch();
+    bool isPrefetching() const { return static_cast<bool>(mPrefetcher); }
+    bool hasPrefetchFailed() const;
+    PrefetchStats prefetchStats() const;
+
+    /*
+     * Lazy loading. When enabled parseIndexed() only indexes the layers, and the geometry of each layer is decoded
+     * upon first access. Loaded layers are evicted in least-recently-used order once the memory budget (bytes) is
+     * exceeded, where a budget of 0 is unlimited. Layers pinned by a LayerPin or GeometryViewRange are not
+     * evicted.
+     */
+    void setLazyLoading(bool state) { mLazyLoading = state; }
+    bool isLazyLoading() const { return mLazyLoading; }
+    void setMemoryBudget(uint64_t bytes);
+    uint64_t memoryBudget() const { return mMemoryBudget; }
+    uint64_t loadedMemory() const;
+
 protected:
     void setReady(bool state) { ready = state; }
     std::string filePath;
-    
+
+    /*
+     * Memory mapped access to the build file. The mapping is shared between the reader and any object holding the
+     * MappedFile pointer, so spans of the data remain valid whilst the pointer is held.
+     */
+    int mapFile();
+    void unmapFile();
+    MappedFile::Ptr mappedFile() const { return mFile; }
+    ByteSpan fileData() const { return mFile ? mFile->span() : ByteSpan(); }
+    ByteCursor fileCursor(size_t pos = 0) const { return ByteCursor(fileData(), pos); }
+
+    /*
+     * Two-phase parsing. Readers which implement readMetadata, indexLayer and decodeLayer may implement parse() by
+     * calling parseIndexed(). The file is first scanned sequentially to locate each layer record, after which the
+     * layer records are decoded concurrently into pre-sized slots of layers.
+     */
+    int parseIndexed();
+    int buildLayerIndex();
+    void createUnloadedLayers();
+    void appendUnloadedLayer(size_t idx);
+
+    // Checks whether the reader implements readMetadata for the mapped file
+    bool supportsIndexing();
+    int decodeIndexedLayer(size_t idx, Layer &layer) const;
+    int decodeLayerEntry(const LayerIndexEntry &entry, Layer &layer) const;
+
+    /**
+     * Reads the header and Model tables at the start of the file.
+     * @return The offset of the first layer record, or -1 if unsupported or on failure
+     */
+    virtual int64_t readMetadata(ByteCursor &cursor);
+
+    /**
+     * Locates the layer record at the cursor position without decoding its geometry and advances the cursor past it.
+     * @return 1 if a layer was indexed, 0 at the end of the layer records or -1 on failure
+     */
+    virtual int indexLayer(ByteCursor &cursor, LayerIndexEntry &entry);
+
+    /**
+     * Fills the layer index. By default the layer records are scanned in sequence using indexLayer, readers may
+     * instead read an index table stored within the file.
+     */
+    virtual int readLayerIndex(ByteCursor &cursor, std::vector<LayerIndexEntry> &index);
+
+    /**
+     * Decodes the geometry of a single layer record. This is called concurrently for different layers.
+     * @return 1 on success or -1 on failure
+     */
+    virtual int decodeLayer(const ByteSpan &record, Layer &layer) const;
+
+protected:
+    std::vector<LayerIndexEntry> mLayerIndex;
+    int64_t mLayerSectionOffset;
+    int64_t mNextLayerOffset;
+    int mNumThreads;
+    bool mLazyLoading;
+    uint64_t mMemoryBudget;
+    std::shared_ptr<LazyLayerLoader> mLazyLoader;
+    std::unique_ptr<LayerPrefetcher> mPrefetcher;
+    std::unique_ptr<LayerFilter> mFilter; // Filter of parseFiltered(), applied to the layers added by refresh()
+
 protected:
     std::vector<Model::Ptr> models;
     std::vector<Layer::Ptr> layers;
 
 private:
     bool ready;
+    MappedFile::Ptr mFile;
 };
 
 }
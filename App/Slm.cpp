@@ -1,58 +1,20 @@
-#include <math.h>
-#include <float.h>
-#include <QPointF>
-#include <QPair>
-#include <QDebug>
-
-#ifndef QT_NO_CONCURRENT
-    #include <QtConcurrent/QtConcurrentMap>
-#endif
+#include <algorithm>
+#include <cmath>
 
 #include "Layer.h"
 #include "Model.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
 #include "Slm.h"
 
-namespace slm {
-
-// Multithreaded operation for generting the layer index
-struct GenLayerIndex
-{
-    GenLayerIndex(Slm *slm) : _slm(slm) { this->_scanMode = this->_slm->getScanMode(); }
-
-    typedef QPair<qint64, Slm::node> result_type;
-
-    QPair<qint64, Slm::node> operator()(const Layer::Ptr &layer) const
-    {
-        QList<LayerGeometry *> lgeoms = layer->getGeometry(this->_scanMode);
-
-        Slm::node layerNode;
-
-        double layerTime = 0.f;
-
-        int j = 0;
-        for(QList<LayerGeometry *>::const_iterator lgeom = lgeoms.begin(); lgeom != lgeoms.end(); ++lgeom, j++) {
-
-            double geomTime = this->_slm->calcGeomTime(*lgeom);
-            layerNode.addChild(j, geomTime);
-            layerTime += geomTime; // Add to the overall layer time
-        }
-
-        layerNode.setNodeValue(layerTime);
-        return QPair<qint64, Slm::node>(layer->getLayerId(), layerNode);
-    }
-private:
-    Slm *_slm;
-    slm::ScanMode _scanMode;
-};
-
-} // end of Namespace
-
 using namespace slm;
 
 Slm::Slm() : layerThickness(0.),
-             scanmode(HATCH_FIRST),
              layerAdditionTime(0.),
-             layerCoolingTime(0.)
+             layerCoolingTime(0.),
+             scanmode(HATCH_FIRST),
+             numThreads(0),
+             cacheArcLengths(true)
 {
 }
 
@@ -60,20 +22,39 @@ Slm::~Slm()
 {
 }
 
-void Slm::invalidateCache()
+void Slm::setLayerCoolingTime(const double &t)
 {
-    _cache.clear();
+    this->layerCoolingTime = t;
+    this->updateLayerTimes();
+}
+
+void Slm::setLayerAdditionTime(const double &t)
+{
+    this->layerAdditionTime = t;
+    this->updateLayerTimes();
 }
 
 void Slm::clear()
 {
     layers.clear();
     models.clear();
-    tindex.clear(); // Clear the Time Index tree
+    styleTable.clear();
+
+    layerGeomOffsets.clear();
+    layerStartTimes.clear();
+    layerScanTimes.clear();
+
+    geomStartTimes.clear();
+    geomTimes.clear();
+    geomStyles.clear();
+    arcLengthTables.clear();
 }
 
 void Slm::parseGeometry()
 {
+    // The build style of each geometry is resolved once, so that queries access the parameters directly
+    styleTable.build(models);
+
     this->createLayerIndex();
 }
 
@@ -98,567 +79,680 @@ void Slm::setBuild(const std::vector<Layer::Ptr> &layers,
     this->parseGeometry();
 }
 
-Model::Ptr Slm::getModelById(uint mid) const
+Model::Ptr Slm::getModelById(uint64_t mid) const
 {
-    // Iterate through all buildStyle elements and check if matching id;
-    // Return true if found
-    QList<Model *>::const_iterator it = this->models.begin();
-    for(; it != this->models.end(); ++it ) {
-        if((*it)->getId() == mid) {
-            return *it;
-        }
-    }
-    return 0;
+    auto result = std::find_if(models.cbegin(), models.cend(),
+                               [&mid](Model::Ptr it){return it->getId() == mid;});
+
+    return (result != models.cend()) ? *result : Model::Ptr();
 }
 
-void Slm::createLayerIndex()
+const BuildStyleParameters * Slm::getBuildStyle(const int layerIdx, const int geomIdx) const
 {
+    if(layerIdx < 0 || layerIdx >= static_cast<int>(layers.size()))
+        return nullptr;
 
-    // Clear the time tree index
-    this->tindex.clear();
+    if(geomIdx < 0 || static_cast<uint64_t>(geomIdx) >= this->getNumLayerGeoms(layerIdx))
+        return nullptr;
 
-    #ifndef QT_NO_CONCURRENT
+    const uint32_t styleIdx = geomStyles[this->geomIndex(layerIdx, geomIdx)];
 
-    typedef QPair<qint64, Slm::node> NodePair ;
+    return (styleIdx != BuildStyleTable::InvalidIndex) ? &styleTable[styleIdx] : nullptr;
+}
 
-    // Multithreaded option for generating layer indexes
+void Slm::createLayerIndex()
+{
+    const size_t numLayers = layers.size();
+    const size_t maxThreads = numThreads > 0 ? numThreads : 0;
 
-     QList<NodePair> layerNodes =  QtConcurrent::blockingMapped(layers, GenLayerIndex(this));
+    ThreadPool &pool = ThreadPool::instance();
 
-    // Add the pairs to the root tree
-    for(QList<NodePair>::const_iterator it = layerNodes.cbegin(); it != layerNodes.cend(); ++it) {
-        this->tindex.addChild((*it).first, (*it).second);
-    }
+    // Offsets of the geometry of each layer within the flat arrays from the number of geometries of each layer
+    layerGeomOffsets.assign(numLayers + 1, 0);
 
-    #else
-    int i = 0;
-    for(QList<Layer::Ptr>::const_iterator it = layers.cbegin(); it != layers.cend(); ++it, i++) {
-        QList<LayerGeometry *> lgeoms = (*it)->getGeometry(scanmode);
-        node layerNode;
+    pool.parallelFor(numLayers, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++)
+            layerGeomOffsets[i] = layers[i]->numGeometry();
+    }, 0, maxThreads);
 
-        double layerTime = 0.f;
+    const uint64_t numGeoms = pool.exclusiveScan(layerGeomOffsets.data(), numLayers, maxThreads);
+    layerGeomOffsets[numLayers] = numGeoms;
 
-        int j = 0;
-        for(QList<LayerGeometry *>::const_iterator lgeom = lgeoms.begin(); lgeom != lgeoms.end(); ++lgeom, j++) {
+    geomStartTimes.resize(numGeoms);
+    geomTimes.resize(numGeoms);
+    geomStyles.resize(numGeoms);
+    layerScanTimes.resize(numLayers);
 
-            double geomTime = this->calcGeomTime(*lgeom);
-            //qDebug() << "Adding node" << i << "," << j << "(" << geomTime << ")";
-            layerNode.addChild(j, geomTime);
-            layerTime += geomTime; // Add to the overall layer time
-        }
-        layerNode.setNodeValue(layerTime);
-        this->tindex.addChild(i, layerNode);
-    }
-    #endif
-}
+    arcLengthTables.clear();
+    arcLengthTables.resize(numGeoms);
 
+    // Each layer writes the scan time of its geometry into its own slots of the arrays
+    pool.parallelFor(numLayers, [&](size_t begin, size_t end) {
 
-bool Slm::isLaserOnByTime(const double t) const
-{
-    bool isLaserOn = false;
+        for(size_t i = begin; i < end; i++) {
 
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+            uint64_t k = layerGeomOffsets[i];
+            double layerTime = 0.0;
 
-        QPointF laserPos;
-        double buildTime = 0.0 - this->getLayerAdditionTime();
+            for(auto geom : layers[i]->geometryViews(scanmode)) {
 
-        int i = 0;
-        for(; it != this->tindex.end(); ++it, i++) {
-            node layerNode = it.value();
-            double layerTime = layerNode.getNodeValue();
+                const uint32_t styleIdx = styleTable.indexOf(geom.mid, geom.bid);
+                const double geomTime = (styleIdx != BuildStyleTable::InvalidIndex) ?
+                                        this->calcGeomTime(geom, styleTable[styleIdx]) : 0.0;
 
-            buildTime += this->getLayerAdditionTime();
+                geomStyles[k] = styleIdx;
+                geomTimes[k] = geomTime;
+                geomStartTimes[k] = layerTime;
 
-            if (this->isBoundByTimeInterval(t,buildTime, layerTime)) {
-                // In Layer Geometry Section
-                isLaserOn = true;
-                break;
+                layerTime += geomTime;
+                k++;
             }
 
-            buildTime += layerTime + this->getLayerCoolingTime();
+            layerScanTimes[i] = layerTime;
         }
-    }
 
-    return isLaserOn;
+    }, 0, maxThreads);
+
+    this->updateLayerTimes();
 }
 
-double Slm::calcGeomTime(LayerGeometry *lgeom) const
+void Slm::updateLayerTimes()
 {
+    // The first layer is scanned from time zero, whilst later layers are preceded by the cooling and addition time
+    const size_t numLayers = layerScanTimes.size();
+    const double layerGap = this->getLayerCoolingTime() + this->getLayerAdditionTime();
 
-    Model *model = this->getModelById(lgeom->mid);
-    BuildStyle *bstyle = model->getBuildStyleById(lgeom->bid);
+    layerStartTimes.resize(numLayers);
 
-    float laserSpeed = bstyle->laserSpeed;
+    for(size_t i = 0; i < numLayers; i++)
+        layerStartTimes[i] = layerScanTimes[i] + layerGap;
 
-    double pathLen = 0.f;
+    ThreadPool::instance().exclusiveScan(layerStartTimes.data(), numLayers, numThreads > 0 ? numThreads : 0);
+}
 
-    if(lgeom->getType() == LayerGeometry::HATCH) {
-        for(int i = 0; i < lgeom->coords.length() / 2; i++) {
-            QPointF v = lgeom->coords.at(2*i+1) - lgeom->coords.at(2*i); // Vector between line segment
-            const double &x = v.rx();
-            const double &y = v.rx();
-            pathLen += sqrt(x*x + y*y);
-        }
-    } else if(lgeom->getType() == LayerGeometry::POLYGON) {
-        for(int i = 0; i < lgeom->coords.length() -1; i++) {
-            QPointF v = lgeom->coords.at(i+1) - lgeom->coords.at(i); // Vector between line segment
-            const double &x = v.rx();
-            const double &y = v.rx();
-            pathLen += sqrt(x*x + y*y);
-        }
-    } else {
-        return 0.f;
-    }
+double Slm::calcGeomTime(const GeometryView &geom, const BuildStyleParameters &bstyle) const
+{
+    if(bstyle.laserSpeed <= 0.0)
+        return 0.0;
 
     // Return the time on this path
-    return pathLen / laserSpeed;
-
+    return BuildStatistics::scanLength(geom) / bstyle.laserSpeed;
 }
 
-void Slm::getPointsInGeom(const double &offset, LayerGeometry *lgeom, QPointF &pnt1, QPointF &pnt2) const
+void Slm::setCacheArcLengths(bool state)
 {
-    Model *model = this->getModelById(lgeom->mid);
-    BuildStyle *bstyle = model->getBuildStyleById(lgeom->bid);
+    cacheArcLengths = state;
 
-    double distTravelled = bstyle->laserSpeed * offset; // Distance covered for offset of this geometry
+    if(!cacheArcLengths) {
+        arcLengthTables.clear();
+        arcLengthTables.resize(geomTimes.size());
+    }
+}
 
-    if(lgeom->getType() == LayerGeometry::HATCH) {
+ArcLengthTable::ConstPtr Slm::getArcLengthTable(const int layerId, const int geomId) const
+{
+    if(geomId < 0 || static_cast<uint64_t>(geomId) >= this->getNumLayerGeoms(layerId))
+        return ArcLengthTable::ConstPtr();
 
-        double pathPos = 0.f;
+    const uint64_t k = this->geomIndex(layerId, geomId);
 
-        for(int i = 0; i < lgeom->coords.length() / 2; ++i) {
-            const QPointF &p1 = lgeom->coords.at(2*i);
-            const QPointF &p2 = lgeom->coords.at(2*i+i);
-            QPointF v = p2 - p1; // Vector between line segmen
-            pathPos += sqrt(pow(v.x(), 2) + pow(v.y(), 2));
+    // Tables are built upon first use. Concurrent queries may build the same table, but only one is retained.
+    ArcLengthTable::ConstPtr table = std::atomic_load(&arcLengthTables[k]);
 
-            if(distTravelled < pathPos) {
-                pnt2 = p2;
-                pnt1 = p1;
-                return;
-            }
-        }
+    if(!table) {
 
+        table = std::make_shared<const ArcLengthTable>(this->layerViews(layerId).at(geomId));
 
-    } else if(lgeom->getType() == LayerGeometry::POLYGON) {
-        ContourGeometry *geom = static_cast<ContourGeometry *>(lgeom);
-        double pathPos = 0.f;
+        if(cacheArcLengths)
+            std::atomic_store(&arcLengthTables[k], table);
+    }
 
-        for(int i = 0; i < geom->coords.length() -1; ++i) {
-            const QPointF &p1 = geom->coords.at(i);
-            const QPointF &p2 = geom->coords.at(i+1);
-            QPointF v = p2 - p1; // Vector between line segmen
-            pathPos += sqrt(pow(v.x(), 2) + pow(v.y(), 2));
+    return table;
+}
 
-            if(distTravelled < pathPos) {
-                pnt2 = p2;
-                pnt1 = p1;
-                return;
-            }
+void Slm::precomputeArcLengths()
+{
+    ThreadPool::instance().parallelFor(layers.size(), [&](size_t begin, size_t end) {
+
+        for(size_t i = begin; i < end; i++) {
+            for(uint64_t j = 0; j < this->getNumLayerGeoms(i); j++)
+                this->getArcLengthTable(i, j);
         }
-    }
+
+    }, 0, numThreads > 0 ? numThreads : 0);
 }
 
-QPointF Slm::getPointInGeom(const double &offset, LayerGeometry *lgeom) const
+bool Slm::locateSegment(const int layerId, const int geomId, const double dist,
+                        Eigen::Vector2d &p1, Eigen::Vector2d &p2, double &segDist) const
 {
+    const ArcLengthTable::ConstPtr table = this->getArcLengthTable(layerId, geomId);
 
-    Model *model = this->getModelById(lgeom->mid);
-    BuildStyle *bstyle = model->getBuildStyleById(lgeom->bid);
+    uint64_t segIdx;
 
-    double distTravelled = bstyle->laserSpeed * offset; // Distance covered for offset of this geometry
+    if(!table || !table->locate(dist, segIdx, segDist))
+        return false;
 
+    const GeometryViewRange views = this->layerViews(layerId);
+    const GeometryView geom = views.at(geomId);
+    const uint64_t row1 = table->segmentFirstRow(segIdx);
+    const uint64_t row2 = table->segmentLastRow(segIdx);
 
-    QPointF laserPos;
-    if(lgeom->getType() == LayerGeometry::HATCH) {
+    p1 = Eigen::Vector2d(geom.data[row1], geom.data[geom.rows + row1]);
+    p2 = Eigen::Vector2d(geom.data[row2], geom.data[geom.rows + row2]);
 
-        double pathPos = 0.f;
-        bool onContour = false;
+    return true;
+}
 
-        QPointF v;
-        QPointF p1;
+void Slm::getPointsInGeom(const double &offset, const int layerId, const int geomId,
+                          const BuildStyleParameters &bstyle, Eigen::Vector2d &p1, Eigen::Vector2d &p2) const
+{
+    double segDist;
+    this->locateSegment(layerId, geomId, bstyle.laserSpeed * offset, p1, p2, segDist);
+}
 
-        for(int i = 0; i < lgeom->coords.length() / 2; ++i) {
+Eigen::Vector2d Slm::getPointInGeom(const double &offset, const int layerId, const int geomId,
+                                    const BuildStyleParameters &bstyle) const
+{
+    // Distance covered for offset of this geometry
+    const double distTravelled = bstyle.laserSpeed * offset;
 
-            v = lgeom->coords.at(2*i+1) -lgeom->coords.at(2*i); // Vector between line segment
+    Eigen::Vector2d p1, p2;
+    double segDist;
 
-            pathPos += sqrt(pow(v.x(), 2) + pow(v.y(), 2));
+    if(!this->locateSegment(layerId, geomId, distTravelled, p1, p2, segDist))
+        return Eigen::Vector2d::Zero();
 
-            if(distTravelled < pathPos) {
-                onContour = true;
-                // Save p1 for later
-                p1 = lgeom->coords.at(2*i);
-                break;
-            }
-        }
+    const double len = (p2 - p1).norm();
 
-        if(onContour) {
+    if(len <= 0.0)
+        return p1;
 
-            double len = sqrt(pow(v.x(), 2) + pow(v.y(), 2));
-            // Find the relative position on the line based on the delta
-            double relPos = (len - (pathPos - distTravelled)) / len;
+    // Find the relative position on the line based on the delta
+    return p1 + (p2 - p1) * (segDist / len);
+}
 
-            laserPos = p1 + v * relPos;
-        } else {
-            return QPointF(); // TODO Throw an exception
-        }
+bool Slm::getGeomIdByTime(const double &t, int &layerId, int &geomId) const
+{
+    if(layerStartTimes.empty() || t < 0.0)
+        return false;
 
-    } else if(lgeom->getType() == LayerGeometry::POLYGON) {
-        ContourGeometry *geom = static_cast<ContourGeometry *>(lgeom);
-        double pathPos = 0.f;
-        bool onContour = false;
+    // The last layer starting before the time
+    const auto layerIt = std::upper_bound(layerStartTimes.begin(), layerStartTimes.end(), t) - 1;
+    const int i = layerIt - layerStartTimes.begin();
 
-        QPointF v;
-        QPointF p1;
+    const double layerTime = t - *layerIt;
 
-        for(int i = 0; i < geom->coords.length() -1; ++i) {
+    if(layerTime >= layerScanTimes[i])
+        return false;
 
-            v = geom->coords.at(i+1) - geom->coords.at(i); // Vector between line segment
-            pathPos += sqrt(pow(v.x(), 2) + pow(v.y(), 2));
+    // The last geometry of the layer starting before the time
+    const auto first = geomStartTimes.begin() + layerGeomOffsets[i];
+    const auto last  = geomStartTimes.begin() + layerGeomOffsets[i + 1];
+    const auto geomIt = std::upper_bound(first, last, layerTime);
 
-            if(distTravelled < pathPos) {
+    if(geomIt == first)
+        return false;
 
-                // Save p1 for later
-                p1 = geom->coords.at(i);
-                onContour = true;
-                break;
-            }
-        }
+    const uint64_t k = (geomIt - 1) - geomStartTimes.begin();
 
-        if(onContour) {
+    if(layerTime >= geomStartTimes[k] + geomTimes[k])
+        return false;
 
-            double len = sqrt(pow(v.x(), 2) + pow(v.y(), 2));
-            // Find the relative position on the line based on the delta
-            double relPos = (len - (pathPos - distTravelled)) / len;
+    layerId = i;
+    geomId = k - layerGeomOffsets[i];
 
-            laserPos = p1 + v * relPos;
-        } else {
-            return QPointF(0.,0.);
-        }
+    return true;
+}
 
-    }
-    return laserPos;
+bool Slm::isLaserOnByTime(const double t) const
+{
+    int layerId, geomId;
+    return this->getGeomIdByTime(t, layerId, geomId);
 }
 
 int Slm::getLayerIdByTime(const double &t) const
 {
-    // It is assumed the first layer always starts from time zero
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    if(layerStartTimes.empty())
+        return -1;
 
-        double layerTimePos = 0.f;
+    // It is assumed the first layer always starts from time zero
+    if(t < 0.0)
+        return 0;
 
-        for(int i =0; it != this->tindex.end(); ++it, i++) {
-            node layerNode = (*it);
+    const int i = (std::upper_bound(layerStartTimes.begin(), layerStartTimes.end(), t) - 1) - layerStartTimes.begin();
 
-            layerTimePos += layerNode.getNodeValue() + this->getLayerCoolingTime();
+    // The layer is added after the laser scan and cooling of the previous layer
+    if(t < layerStartTimes[i] + layerScanTimes[i] + this->getLayerCoolingTime())
+        return i;
 
-            if(t < layerTimePos) {
-                return i;
-            }
+    return (i + 1 < static_cast<int>(layers.size())) ? i + 1 : -1;
+}
 
-            layerTimePos += this->getLayerAdditionTime(); // The layer is added after the laser scan for the next layer
-        }
+Layer::Ptr Slm::getLayerByTime(const double &t) const
+{
+    const int layerId = this->getLayerIdByTime(t);
+    return (layerId >= 0) ? layers[layerId] : Layer::Ptr();
+}
 
-        // Failed to find the layer by time
+double Slm::getTimeByLayerId(const int layerId) const
+{
+    if(layerId < 0 || layerId >= static_cast<int>(layers.size()))
         return -1;
-    }
+
+    return layerStartTimes[layerId];
 }
 
-double Slm::getTimeByLayerId(const int layerId) const
+double Slm::getTimeByLayerGeomId(const int layerId, const int geomId) const
 {
-    Q_ASSERT(layerId >= this->layers.length());
+    if(layerId < 0 || layerId >= static_cast<int>(layers.size()))
+        return -1;
 
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    if(geomId < 0 || static_cast<uint64_t>(geomId) >= this->getNumLayerGeoms(layerId))
+        return -1;
 
-        double layerTimePos = 0.f;
-        int i = layerId;
+    return layerStartTimes[layerId] + geomStartTimes[this->geomIndex(layerId, geomId)];
+}
 
-        // Use reverse delta loop to count first level of time index tree
-        while(i--) {
-            const node layerNode = (it++).value();
-            layerTimePos += this->getLayerAdditionTime() + layerNode.getNodeValue() + this->getLayerCoolingTime();
-        }
+double Slm::getLayerScanTime(const int layerId) const
+{
+    if(layerId < 0 || layerId >= static_cast<int>(layers.size()))
+        return -1;
 
-        return layerTimePos;
-    }
+    return layerScanTimes[layerId];
 }
-double Slm::getTimeByLayerGeomId(const int layerId, const int geomId) const
+
+uint64_t Slm::getNumLayerGeoms(const int layerId) const
 {
-    Q_ASSERT(layerId >= this->layers.length());
+    if(layerId < 0 || layerId >= static_cast<int>(layers.size()))
+        return 0;
 
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    return layerGeomOffsets[layerId + 1] - layerGeomOffsets[layerId];
+}
 
-        double layerTimePos = 0.f;
-        int i = layerId;
+double Slm::getGeomTime(const int layerId, const int geomId) const
+{
+    if(geomId < 0 || static_cast<uint64_t>(geomId) >= this->getNumLayerGeoms(layerId))
+        return -1;
 
-        // Use reverse delta loop to count first level of time index tree
-        node layerNode = it.value();
-        while(i--) {
-            layerNode = (it++).value();
-            layerTimePos += this->getLayerAdditionTime() + layerNode.getNodeValue() + this->getLayerCoolingTime();
-        }
+    return geomTimes[this->geomIndex(layerId, geomId)];
+}
 
-        node::const_iterator git = layerNode.getChildren().begin();
+LayerGeometry::Ptr Slm::getLayerGeometryByTime(const double t) const
+{
+    int layerId, geomId;
 
-        int j = geomId;
+    if(!this->getGeomIdByTime(t, layerId, geomId))
+        return LayerGeometry::Ptr();
 
-        while(j--) {
-            node geomNode = (git++).value();
-            layerTimePos += geomNode.getNodeValue();
-        }
+    const Layer::Ptr &layer = layers[layerId];
 
-        return layerTimePos;
-    }
+    return layer->geometryAt(layer->geometryOrder(scanmode)[geomId]);
 }
 
-LayerGeometry * Slm::getLayerGeometryByTime(const double t) const
+void Slm::getLaserParameters(const double &t, float &power, int &expTime, int &pntDist, bool &isLaserOn) const
 {
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    // Set laser default to off
+    isLaserOn = false;
 
-        double buildTime = -this->getLayerAdditionTime();
+    int layerId, geomId;
 
-        for(int i = 0; it != this->tindex.end(); ++it, i++) {
-            const node layerNode = it.value();
-            const double layerTime = layerNode.getNodeValue();
+    if(!this->getGeomIdByTime(t, layerId, geomId))
+        return;
 
-            buildTime += this->getLayerAdditionTime();
+    const BuildStyleParameters *bstyle = this->getBuildStyle(layerId, geomId);
 
-            if(t > buildTime - FLT_EPSILON &&
-               t < buildTime + layerTime - FLT_EPSILON) {
+    if(!bstyle)
+        return;
 
-                node::const_iterator lgeom =  layerNode.begin();
-                for(int j = 0; lgeom != layerNode.end(); ++lgeom, j++) {
+    power   = bstyle->laserPower;
+    pntDist = bstyle->pointDistance;
+    expTime = bstyle->pointExposureTime;
+    isLaserOn = true;
+}
 
-                    const node layerGeomNode = lgeom.value();
-                    double lGeomTime = layerGeomNode.getNodeValue();
+void Slm::getLaserVelocity(const double &t, double &dx, double &dy, bool &isLaserOn) const
+{
+    isLaserOn = false;
 
-                    if(t > buildTime - FLT_EPSILON &&
-                       t < buildTime + lGeomTime - FLT_EPSILON) {
-                        // Access the layer using index i
-                        Layer::Ptr layer = layers.at(i);
-                        return layer->getGeometry(scanmode).at(j);
-                    }
-                }
+    int layerId, geomId;
 
-                // TODO throw an exception since the layer geom at this time was not found
-                return 0;
-            }
+    if(!this->getGeomIdByTime(t, layerId, geomId))
+        return;
 
-            buildTime += layerTime + this->getLayerCoolingTime(); // Add the layer time if the time is not in this layer
-        }
-    } else {
-        return 0;
-    }
+    const BuildStyleParameters *bstyle = this->getBuildStyle(layerId, geomId);
+
+    if(!bstyle)
+        return;
+
+    Eigen::Vector2d p1, p2;
+    this->getPointsInGeom(t - this->getTimeByLayerGeomId(layerId, geomId), layerId, geomId, *bstyle, p1, p2);
+
+    const double length = (p2 - p1).norm();
+
+    // Normalize the point path
+    const Eigen::Vector2d v = (length > 0.0) ? Eigen::Vector2d((p2 - p1) / length * bstyle->laserSpeed) :
+                                               Eigen::Vector2d::Zero();
+
+    dx = v.x();
+    dy = v.y();
+    isLaserOn = true;
 }
 
-void Slm::getLaserParameters(const double &t, float &power, int &expTime, int &pntDist, bool &isLaserOn) const
+void Slm::getLaserPosition(const double &t, double &x, double &y, double &z, bool &isLaserOn) const
 {
-    // Set laser default to off
     isLaserOn = false;
 
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    int layerId, geomId;
 
-        double buildTime = 0.0 - this->getLayerAdditionTime();
+    if(!this->getGeomIdByTime(t, layerId, geomId))
+        return;
 
-        int i = 0;
-        for(; it != this->tindex.end(); ++it, i++) {
-            node layerNode = it.value();
-            double layerTime = layerNode.getNodeValue();
+    const BuildStyleParameters *bstyle = this->getBuildStyle(layerId, geomId);
 
-            if( this->isBoundByTimeInterval(t,buildTime,this->getLayerAdditionTime()) ) {
-                return;
-            }
+    if(!bstyle)
+        return;
+
+    const Eigen::Vector2d laserPos = this->getPointInGeom(t - this->getTimeByLayerGeomId(layerId, geomId),
+                                                          layerId, geomId, *bstyle);
+
+    x = laserPos.x();
+    y = laserPos.y();
+    z = this->layerThickness * layerId;
+    isLaserOn = true;
+}
+
+void LaserStateSeries::resize(uint64_t n)
+{
+    time.resize(n);
+    position.resize(n, 3);
+    velocity.resize(n, 2);
+    power.resize(n);
+    exposureTime.resize(n);
+    pointDistance.resize(n);
+    layer.resize(n);
+    laserOn.resize(n);
+}
 
-            buildTime += this->getLayerAdditionTime();
+void Slm::sampleLaserState(const Eigen::ArrayXd &times, LaserStateSeries &series) const
+{
+    this->sampleLaserState(times.data(), times.size(), series);
+}
 
-            if(t > buildTime - FLT_EPSILON &&
-               t < buildTime + layerTime - FLT_EPSILON) {
+void Slm::sampleLaserState(const double t0, const double dt, uint64_t n, LaserStateSeries &series) const
+{
+    Eigen::ArrayXd times(n);
 
-                int j = 0;
-                node::const_iterator lgeom =  layerNode.begin();
-                for(; lgeom != layerNode.end(); ++lgeom, j++) {
+    for(uint64_t i = 0; i < n; i++)
+        times[i] = t0 + dt * i;
 
-                    node layerGeomNode = lgeom.value();
-                    double lGeomTime = layerGeomNode.getNodeValue();
+    this->sampleLaserState(times.data(), n, series);
+}
 
-                    if(t > buildTime - FLT_EPSILON &&
-                       t < buildTime + lGeomTime - FLT_EPSILON) {
-                        // Access the layer using index i
-                        Layer::Ptr layer = layers.at(i);
-                        LayerGeometry *lgeom = layer->getGeometry(scanmode).at(j);
-                        Model *model = this->getModelById(lgeom->mid);
-                        BuildStyle *bstyle = model->getBuildStyleById(lgeom->bid);
+void Slm::sampleLaserState(const double *times, uint64_t count, LaserStateSeries &series) const
+{
+    series.resize(count);
 
-                        power   = bstyle->laserPower;
-                        pntDist = bstyle->pointDistance;
-                        expTime = bstyle->pointExposureTime;
-                        isLaserOn = true;
+    // Each chunk locates its first sample by binary search and then sweeps forward through the build
+    ThreadPool::instance().parallelFor(count, [&](size_t begin, size_t end) {
+        this->sweepLaserState(times, begin, end, series);
+    }, 4096, numThreads > 0 ? numThreads : 0);
+}
 
-                        return;
-                    }
-                    buildTime += lGeomTime;
-                }
+void Slm::sweepLaserState(const double *times, uint64_t begin, uint64_t end, LaserStateSeries &series) const
+{
+    SweepCursor cursor;
+    LaserSample sample;
 
-                // TODO throw an exception
-                return;
-            }
+    for(uint64_t s = begin; s < end; s++) {
 
-            if(this->isBoundByTimeInterval(t, buildTime, this->getLayerAdditionTime())) {
-                return;
-            }
+        this->sweepSample(times[s], cursor, sample);
 
-            buildTime += layerTime + this->getLayerCoolingTime();
-        }
-    } else {
+        series.time[s] = times[s];
+        series.position.row(s) = sample.position.transpose();
+        series.velocity.row(s) = sample.velocity.transpose();
+        series.power[s] = sample.power;
+        series.exposureTime[s] = sample.exposureTime;
+        series.pointDistance[s] = sample.pointDistance;
+        series.layer[s] = sample.layer;
+        series.laserOn[s] = sample.laserOn;
     }
 }
 
-
-void Slm::getLaserVelocity(const double &t, double &dx, double &dy, bool &isLaserOn) const
+void Slm::sweepSample(const double t, SweepCursor &cursor, LaserSample &sample) const
 {
-    isLaserOn = false;
+    const int numLayers = static_cast<int>(layers.size());
 
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    sample = LaserSample();
+    sample.layer = (numLayers > 0) ? 0 : -1;
 
-        double buildTime = -this->getLayerAdditionTime();
+    if(numLayers == 0 || t < 0.0)
+        return;
 
-        int i = 0;
-        for(; it != this->tindex.end(); ++it, i++) {
-            node layerNode = it.value();
-            double layerTime = layerNode.getNodeValue();
+    int &i = cursor.layer;
+    uint64_t &k = cursor.geom;
+    uint64_t &segIdx = cursor.segment;
+    ArcLengthTable::ConstPtr &table = cursor.table;
 
-            buildTime += this->getLayerAdditionTime();
+    if(i < 0 || t < cursor.prevTime) {
 
-            if(t > buildTime - FLT_EPSILON &&
-               t < buildTime + layerTime - FLT_EPSILON) {
+        // Locate the layer and geometry by binary search when the sweep begins or the time moves backwards
+        i = (std::upper_bound(layerStartTimes.begin(), layerStartTimes.end(), t) - 1) - layerStartTimes.begin();
 
-                int j = 0;
-                node::const_iterator lgeom =  layerNode.begin();
-                for(; lgeom != layerNode.end(); ++lgeom, j++) {
+        const auto first = geomStartTimes.begin() + layerGeomOffsets[i];
+        const auto last  = geomStartTimes.begin() + layerGeomOffsets[i + 1];
+        const auto geomIt = std::upper_bound(first, last, t - layerStartTimes[i]);
 
-                    node layerGeomNode = lgeom.value();
-                    double lGeomTime = layerGeomNode.getNodeValue();
+        k = (geomIt == first) ? layerGeomOffsets[i] : (geomIt - 1) - geomStartTimes.begin();
+        table.reset();
 
-                    if(t > buildTime - FLT_EPSILON &&
-                       t < buildTime + lGeomTime - FLT_EPSILON) {
-                        Layer::Ptr layer = layers.at(i);
-                        LayerGeometry *lgeom = layer->getGeometry(scanmode).at(j);
-                        Model *model = this->getModelById(lgeom->mid);
-                        BuildStyle *bstyle = model->getBuildStyleById(lgeom->bid);
+    } else {
 
-                        QPointF p1, p2, v;
-                        this->getPointsInGeom(t-buildTime, lgeom, p1, p2);
-                        double length = sqrt( pow(p2.rx() - p1.rx(),2) + pow(p2.ry() - p1.ry(), 2) );
-                        v = (p2 - p1) / length; // Normalize the point path
-                        v *= bstyle->laserSpeed;
+        while(i + 1 < numLayers && layerStartTimes[i + 1] <= t) {
+            i++;
+            k = layerGeomOffsets[i];
+            table.reset();
+        }
+    }
 
-                        dx = v.x();
-                        dy = v.y();
-                        isLaserOn = true;
+    cursor.prevTime = t;
 
-                        return;
+    const double layerTime = t - layerStartTimes[i];
 
-                    }
-                }
-                // TODO throw an exception
-                return;
-            }
-        }
+    // The next layer is added after the laser scan and cooling of the layer, matching getLayerIdByTime
+    if(layerTime < layerScanTimes[i] + this->getLayerCoolingTime())
+        sample.layer = i;
+    else
+        sample.layer = (i + 1 < numLayers) ? i + 1 : -1;
+
+    if(layerTime >= layerScanTimes[i])
+        return;
+
+    // Advance to the last geometry of the layer starting before the time
+    while(k + 1 < layerGeomOffsets[i + 1] && geomStartTimes[k + 1] <= layerTime) {
+        k++;
+        table.reset();
     }
-}
 
-void Slm::getLaserPosition(const double &t, double &x, double &y, double &z, bool &isLaserOn) const
-{
-    isLaserOn = false;
+    if(layerTime < geomStartTimes[k] || layerTime >= geomStartTimes[k] + geomTimes[k])
+        return;
+
+    if(geomStyles[k] == BuildStyleTable::InvalidIndex)
+        return;
 
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    const BuildStyleParameters &bstyle = styleTable[geomStyles[k]];
 
-        QPointF laserPos;
-        double buildTime = -this->getLayerAdditionTime();
+    if(!table) {
+        if(cursor.views.layer() != layers[i].get())
+            cursor.views = this->layerViews(i);
 
-        int i = 0;
-        for(; it != this->tindex.end(); ++it, i++) {
-            node layerNode = it.value();
-            double layerTime = layerNode.getNodeValue();
+        cursor.view = cursor.views.at(k - layerGeomOffsets[i]);
+        table = this->getArcLengthTable(i, k - layerGeomOffsets[i]);
+        segIdx = 0;
+    }
 
-            buildTime += this->getLayerAdditionTime();
+    if(table->numSegments() == 0)
+        return;
 
-            if(t > buildTime - FLT_EPSILON &&
-               t < buildTime + layerTime - FLT_EPSILON) {
+    const GeometryView &geom = cursor.view;
+    const double dist = bstyle.laserSpeed * (layerTime - geomStartTimes[k]);
 
-                int j = 0;
-                node::const_iterator lgeom =  layerNode.begin();
-                for(; lgeom != layerNode.end(); ++lgeom, j++) {
+    // Scan vectors are passed in order, unless the sweep has moved backwards within the geometry
+    if(dist < table->segmentStart(segIdx))
+        segIdx = 0;
 
-                    node layerGeomNode = lgeom.value();
-                    double lGeomTime = layerGeomNode.getNodeValue();
+    while(segIdx + 1 < table->numSegments() && table->segmentStart(segIdx + 1) <= dist)
+        segIdx++;
 
-                    if(t > buildTime - FLT_EPSILON &&
-                       t < buildTime + lGeomTime - FLT_EPSILON) {
-                        // Access the layer using index i
-                        Layer::Ptr layer = layers.at(i);
-                        LayerGeometry *lgeom = layer->getGeometry(scanmode).at(j);
-                        laserPos = this->getPointInGeom(t-buildTime, lgeom);
+    const uint64_t row1 = table->segmentFirstRow(segIdx);
+    const uint64_t row2 = table->segmentLastRow(segIdx);
 
-                        x = laserPos.x();
-                        y = laserPos.y();
-                        z = this->layerThickness *i;
-                        isLaserOn = true;
+    const Eigen::Vector2d p1(geom.data[row1], geom.data[geom.rows + row1]);
+    const Eigen::Vector2d p2(geom.data[row2], geom.data[geom.rows + row2]);
 
-                        return;
-                    }
-                    buildTime += lGeomTime;
-                }
-                break;
-            }
+    const double segLength = table->segmentStart(segIdx + 1) - table->segmentStart(segIdx);
+    const double segDist = std::min(std::max(dist - table->segmentStart(segIdx), 0.0), segLength);
+
+    Eigen::Vector2d pos = p1;
+
+    if(segLength > 0.0) {
+        pos = p1 + (p2 - p1) * (segDist / segLength);
+        sample.velocity = (p2 - p1) / segLength * bstyle.laserSpeed;
+    }
+
+    sample.position << pos.x(), pos.y(), this->layerThickness * i;
+    sample.power = bstyle.laserPower;
+    sample.exposureTime = bstyle.pointExposureTime;
+    sample.pointDistance = bstyle.pointDistance;
+    sample.laserOn = true;
+}
+
+uint64_t Slm::getLaserScansByTime(const double t0, const double t1, std::vector<LaserScan> &scans) const
+{
+    const size_t numScans = scans.size();
+    const int numLayers = static_cast<int>(layers.size());
+
+    if(numLayers == 0 || t1 < t0)
+        return 0;
 
-            buildTime += layerTime + this->getLayerCoolingTime();
+    // The first layer with a laser scan ending at or after the start of the window
+    const auto layerIt = std::partition_point(layerStartTimes.begin(), layerStartTimes.end(), [&](const double &start) {
+        return start + layerScanTimes[&start - layerStartTimes.data()] < t0;
+    });
+
+    for(int i = layerIt - layerStartTimes.begin(); i < numLayers && layerStartTimes[i] <= t1; i++) {
+
+        const double layerTime = t0 - layerStartTimes[i];
+
+        // The first geometry of the layer ending at or after the start of the window
+        const auto first = geomStartTimes.begin() + layerGeomOffsets[i];
+        const auto last  = geomStartTimes.begin() + layerGeomOffsets[i + 1];
+        const auto geomIt = std::partition_point(first, last, [&](const double &start) {
+            return start + geomTimes[&start - geomStartTimes.data()] < layerTime;
+        });
+
+        for(uint64_t k = geomIt - geomStartTimes.begin(); k < layerGeomOffsets[i + 1]; k++) {
+
+            if(layerStartTimes[i] + geomStartTimes[k] > t1)
+                return scans.size() - numScans;
+
+            if(geomStyles[k] != BuildStyleTable::InvalidIndex)
+                this->appendLaserScans(i, k - layerGeomOffsets[i], t0, t1, scans);
         }
-    } else {
     }
+
+    return scans.size() - numScans;
 }
 
-double Slm::getBuildTime() const
+void Slm::appendLaserScans(const int layerId, const int geomId, const double t0, const double t1,
+                           std::vector<LaserScan> &scans) const
 {
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    const uint64_t k = this->geomIndex(layerId, geomId);
+    const double geomStart = layerStartTimes[layerId] + geomStartTimes[k];
+    const double laserSpeed = styleTable[geomStyles[k]].laserSpeed;
+
+    const GeometryViewRange views = this->layerViews(layerId);
+    const GeometryView geom = views.at(geomId);
+
+    if(geom.cols < 2)
+        return;
+
+    LaserScan scan;
+    scan.layer = layerId;
+    scan.mid   = geom.mid;
+    scan.bid   = geom.bid;
+    scan.type  = geom.type;
+
+    if(geom.type == LayerGeometry::PNTS) {
 
-        double buildTime = 0;
-        for(; it != this->tindex.end(); ++it) {
-            node layerNode = it.value();
-            buildTime += this->getLayerAdditionTime() + layerNode.getNodeValue() + this->getLayerCoolingTime();
+        // Points are exposed without taking any time along the path
+        if(geomStart < t0)
+            return;
+
+        scan.tStart = scan.tEnd = geomStart;
+
+        for(uint64_t row = 0; row < geom.rows; row++) {
+            scan.start = scan.end = Eigen::Vector2f(geom.data[row], geom.data[geom.rows + row]);
+            scans.push_back(scan);
         }
 
-        buildTime -= this->getLayerAdditionTime(); // First layer doesn't include addition time
+        return;
+    }
 
-        return buildTime;
+    const ArcLengthTable::ConstPtr table = this->getArcLengthTable(layerId, geomId);
+    const uint64_t numSegs = table->numSegments();
 
-    } else {
-        return -1;
+    // The first scan vector ending at or after the start of the window
+    uint64_t segIdx = 0;
+
+    if(laserSpeed > 0.0)
+        segIdx = table->lowerBound((t0 - geomStart) * laserSpeed);
+    else if(geomStart < t0)
+        return;
+
+    for(; segIdx < numSegs; segIdx++) {
+
+        scan.tStart = geomStart;
+        scan.tEnd   = geomStart;
+
+        if(laserSpeed > 0.0) {
+            scan.tStart += table->segmentStart(segIdx) / laserSpeed;
+            scan.tEnd   += table->segmentStart(segIdx + 1) / laserSpeed;
+        }
+
+        if(scan.tStart > t1)
+            break;
+
+        const uint64_t row1 = table->segmentFirstRow(segIdx);
+        const uint64_t row2 = table->segmentLastRow(segIdx);
+
+        scan.start = Eigen::Vector2f(geom.data[row1], geom.data[geom.rows + row1]);
+        scan.end   = Eigen::Vector2f(geom.data[row2], geom.data[geom.rows + row2]);
+
+        scans.push_back(scan);
     }
 }
 
+double Slm::getBuildTime() const
+{
+    if(layerStartTimes.empty())
+        return -1;
+
+    // The last layer is not followed by the addition of another layer
+    return layerStartTimes.back() + layerScanTimes.back() + this->getLayerCoolingTime();
+}
+
 double Slm::getBuildEnergy() const
 {
-    if(!this->tindex.empty()) {
-        node::const_iterator it =  this->tindex.begin();
+    if(layerStartTimes.empty())
+        return -1;
 
-        double buildTime = 0;
-        for(; it != this->tindex.end(); ++it) {
-           // buildTime += (float) (*it).value;
-        }
+    double buildEnergy = 0.0;
 
-        return buildTime;
+    for(size_t k = 0; k < geomTimes.size(); k++) {
 
-    } else {
-        return -1;
+        if(geomStyles[k] != BuildStyleTable::InvalidIndex)
+            buildEnergy += styleTable[geomStyles[k]].laserPower * geomTimes[k];
     }
-}
 
+    return buildEnergy;
+}
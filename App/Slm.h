@@ -3,22 +3,69 @@
 
 #include "SLM_Export.h"
 
-#include <cfloat>
+#include <cstdint>
 #include <vector>
 
-#include <Base/Tree.h>
+#include <Eigen/Dense>
+
+#include "ArcLengthTable.h"
+#include "BuildStyleTable.h"
 #include "Layer.h"
 #include "Model.h"
 
 namespace slm {
     // Forward declaration
     class Iterator;
-    class GenLayerIndex;
+    class LayerGeomIterator;
+    class LaserScanIterator;
 }
 
 namespace slm
 {
 
+/**
+ * @brief The LaserStateSeries struct holds the state of the laser sampled at a series of times. Each array holds one
+ * row for each sample. The position, velocity and parameters are zero for samples whilst the laser is off.
+ */
+struct SLM_EXPORT LaserStateSeries
+{
+    void resize(uint64_t n);
+    uint64_t size() const { return time.size(); }
+
+    Eigen::ArrayXd  time;
+    Eigen::ArrayXXd position;       // Laser position (x, y, z)
+    Eigen::ArrayXXd velocity;       // Laser velocity (u, v)
+    Eigen::ArrayXf  power;          // Laser Power (W)
+    Eigen::ArrayXi  exposureTime;   // Point Exposure Time
+    Eigen::ArrayXi  pointDistance;  // Point Distance
+    Eigen::ArrayXi  layer;          // Index of the layer as given by Slm::getLayerIdByTime
+    Eigen::Array<bool, Eigen::Dynamic, 1> laserOn;
+};
+
+// Scan vector of the laser between two points. Points are scanned with the same start and end.
+struct LaserScan
+{
+    Eigen::Vector2f  start;
+    Eigen::Vector2f  end;
+    double  tStart;
+    double  tEnd;
+    int     layer;
+    uint32_t mid;   // Model Id
+    uint32_t bid;   // Build Style Id
+    LayerGeometry::TYPE type;
+};
+
+/**
+ * @brief The Slm class simulates the scanning of a build over time. The scan time of each geometry is indexed in
+ * flat arrays, with the geometry of each layer stored contiguously in the order of the scan mode and located by the
+ * offsets of each layer. The start time of each layer and the start time of each geometry relative to its layer are
+ * prefix sums of the scan times, so that the layer and geometry scanned at a time are found by binary search. The
+ * index is built concurrently, with each layer computing the scan times of its geometry into its own slots before
+ * the start times of the layers are found by a parallel prefix sum.
+ *
+ * The build begins with scanning the first layer at time zero. Each layer is followed by the cooling time and the
+ * addition time of the next layer of powder, during which the laser is off.
+ */
 class SLM_EXPORT Slm
 {
 public:
@@ -26,16 +73,13 @@ public:
     ~Slm();
 
     friend class Iterator;
-    friend struct GenLayerIndex;
+    friend class LayerGeomIterator;
+    friend class LaserScanIterator;
 
 public:
-    typedef base::Tree<uint64_t, double> tree;
-    typedef base::Node<uint64_t, double> node;
-    //typedef boost::property_tree::ptree tree;
-
     // Setters and Getters for manipulating the time between layers.
-    void setLayerCoolingTime(const double &t) { this->layerCoolingTime = t; }
-    void setLayerAdditionTime(const double &t) { this->layerAdditionTime = t; }
+    void setLayerCoolingTime(const double &t);
+    void setLayerAdditionTime(const double &t);
     inline double getLayerCoolingTime() const { return layerCoolingTime; }
     inline double getLayerAdditionTime() const { return layerAdditionTime; }
 
@@ -47,18 +91,39 @@ public:
                   const double lCoolingTime  = 0.);
     void clear();
 
-    inline tree getTimeIndex()  const { return this->tindex;}
+    // Number of threads used for indexing the build, 0 uses all available threads
+    void setNumThreads(int num) { numThreads = num; }
+    int getNumThreads() const { return numThreads; }
 
     /**
      * Layer Information
      */
     inline double getLayerThickness() const { return this->layerThickness;}
+    inline uint64_t numLayers() const { return layers.size(); }
+
+    // Returns the index of the layer being scanned, cooled or added at the time, or -1 after the build
     int getLayerIdByTime(const double &t) const ;
     Layer::Ptr getLayerByTime(const double &t) const;
 
     double getTimeByLayerId(const int layerId) const;
     double getTimeByLayerGeomId(const int layerId, const int geomId) const;
 
+    // Time taken to scan the geometry of the layer
+    double getLayerScanTime(const int layerId) const;
+
+    // Number of geometries in the layer and the time taken to scan each geometry
+    uint64_t getNumLayerGeoms(const int layerId) const;
+    double getGeomTime(const int layerId, const int geomId) const;
+
+    /**
+     * Locates the geometry scanned at the time
+     * @param t - Current Time (s)
+     * @param layerId - Index of the layer
+     * @param geomId - Index of the geometry within the layer in the order of the scan mode
+     * @return true if a geometry is scanned at the time
+     */
+    bool getGeomIdByTime(const double &t, int &layerId, int &geomId) const;
+
     /**
       * @param  t - Current Time (s)
       * @param  x - Laser Position on current layer
@@ -81,17 +146,38 @@ public:
       * @param  t - Current Time (s)
       * @param  deltaX - Current X Velocity for laser
       * @param  deltaY - Curreny Y Velocity for laser
-      * @param  pntDist - Laser Point Distance
       * @param  isLaserOn - Determines if the laser is currently on (e.g. addition of powder layer)
       */
     void getLaserVelocity(const double &t, double &deltaX, double &deltaY, bool &isLaserOn) const;
 
     bool isLaserOnByTime(const double t) const;
 
+    /**
+     * Samples the state of the laser at each time. The times are divided into chunks which are sampled concurrently,
+     * with each chunk located once and then swept forward through the layers, geometry and scan vectors, so that
+     * sorted times are sampled in a single pass. Unsorted times are supported but located individually.
+     */
+    void sampleLaserState(const double *times, uint64_t count, LaserStateSeries &series) const;
+    void sampleLaserState(const Eigen::ArrayXd &times, LaserStateSeries &series) const;
+
+    // Samples the state of the laser at the n times t0, t0 + dt, ...
+    void sampleLaserState(const double t0, const double dt, uint64_t n, LaserStateSeries &series) const;
+
+    /**
+     * Finds the laser scans active within the time window, i.e. starting at or before t1 and ending at or after t0.
+     * Scan vectors are scanned in sequence without overlapping, so the first scan is located by binary search of the
+     * layers, geometry and arc-length table, and the following scans are read until the end of the window.
+     * @param t0 - Start of the window (s)
+     * @param t1 - End of the window (s)
+     * @param scans - Scans appended in the order they are scanned
+     * @return The number of scans appended
+     */
+    uint64_t getLaserScansByTime(const double t0, const double t1, std::vector<LaserScan> &scans) const;
+
     /**
      * @brief getLayerGeometryByTime
      * @param t - Current Tmime
-     * @return LayerGeometry * - the current Layer Geometry at time t
+     * @return LayerGeometry - the current Layer Geometry at time t or a null pointer
      */
     LayerGeometry::Ptr getLayerGeometryByTime(const double t) const;
 
@@ -104,39 +190,106 @@ public:
     const std::vector<Model::Ptr> & getModels() const { return models;}
 
     inline ScanMode getScanMode() const { return scanmode; }
-    Model::Ptr getModelById(uint id) const;
+    Model::Ptr getModelById(uint64_t id) const;
 
-protected:
-    void rebuildCache();
-    void invalidateCache();
-    void parseGeometry();
+    const BuildStyleTable & getBuildStyleTable() const { return styleTable; }
 
-    void createLayerIndex();
+    // Parameters of the build style of the geometry at the position within the layer for the scan mode
+    const BuildStyleParameters * getBuildStyle(const int layerIdx, const int geomIdx) const;
 
-    void getPointsInGeom(const double &offset, LayerGeometry *lgeom, QPointF &p1, QPointF &p2) const;
-    QPointF getPointInGeom(const double &offset, LayerGeometry *lgeom) const;
+    /*
+     * Cumulative arc-length tables of the geometry used to locate the laser along its path. The tables are built upon
+     * first use and cached for the geometry unless caching is disabled. Queries may be made concurrently.
+     */
+    void setCacheArcLengths(bool state);
+    bool getCacheArcLengths() const { return cacheArcLengths; }
+    ArcLengthTable::ConstPtr getArcLengthTable(const int layerId, const int geomId) const;
 
-    double calcGeomTime(LayerGeometry *lgeom) const;
+    // Builds the arc-length tables of all geometry in advance
+    void precomputeArcLengths();
 
 protected:
-    tree tindex;
+    void parseGeometry();
 
-    // Convenience helper function to check if time is within bounds
-    bool isBoundByTimeInterval(const double t, const double sTime, const double delta) const {
-        return t > sTime - DBL_EPSILON && t < sTime + delta - DBL_EPSILON;
-    }
+    void createLayerIndex();
+    void updateLayerTimes();
+
+    // Index of the geometry within the flat arrays
+    uint64_t geomIndex(const int layerId, const int geomId) const { return layerGeomOffsets[layerId] + geomId; }
+
+    // Geometry of the layer in the order of the scan mode. The layer is pinned whilst the range is held.
+    GeometryViewRange layerViews(const int layerId) const { return layers[layerId]->geometryViews(scanmode); }
+
+    // Locates the scan vector at the distance along the path of the geometry
+    bool locateSegment(const int layerId, const int geomId, const double dist,
+                       Eigen::Vector2d &p1, Eigen::Vector2d &p2, double &segDist) const;
+
+    void getPointsInGeom(const double &offset, const int layerId, const int geomId,
+                         const BuildStyleParameters &bstyle, Eigen::Vector2d &p1, Eigen::Vector2d &p2) const;
+    Eigen::Vector2d getPointInGeom(const double &offset, const int layerId, const int geomId,
+                                   const BuildStyleParameters &bstyle) const;
+
+    double calcGeomTime(const GeometryView &geom, const BuildStyleParameters &bstyle) const;
+
+    // State of the laser at a single time, as held by each row of a LaserStateSeries
+    struct LaserSample
+    {
+        Eigen::Vector3d position = Eigen::Vector3d::Zero();
+        Eigen::Vector2d velocity = Eigen::Vector2d::Zero();
+        float power = 0.0f;
+        int exposureTime = 0;
+        int pointDistance = 0;
+        int layer = -1;
+        bool laserOn = false;
+    };
+
+    // Position of a sweep through the time index, which is retained between consecutive samples
+    struct SweepCursor
+    {
+        int layer = -1;
+        uint64_t geom = 0;
+        uint64_t segment = 0;
+        double prevTime = 0.0;
+
+        GeometryViewRange views; // Pins the layer of the current geometry
+        GeometryView view;
+        ArcLengthTable::ConstPtr table;
+    };
+
+    // Samples the laser at a single time, advancing the cursor from its previous sample
+    void sweepSample(const double t, SweepCursor &cursor, LaserSample &sample) const;
+    void sweepLaserState(const double *times, uint64_t begin, uint64_t end, LaserStateSeries &series) const;
+
+    void appendLaserScans(const int layerId, const int geomId, const double t0, const double t1,
+                          std::vector<LaserScan> &scans) const;
 
+protected:
     double layerThickness;
     double layerAdditionTime; // Time taken for new layer of powder to be added
     double layerCoolingTime;  // Time after last laser scan for layer to cool
 
     ScanMode scanmode;
+    int numThreads;
 
     std::vector<Layer::Ptr> layers;
     std::vector<Model::Ptr> models;
 
-private:
-    tree _cache;
+    BuildStyleTable styleTable;
+
+    /*
+     * Time index. The geometry of layer i occupies [layerGeomOffsets[i], layerGeomOffsets[i + 1]) of the geometry
+     * arrays, which are in the order of the scan mode.
+     */
+    std::vector<uint64_t> layerGeomOffsets;
+    std::vector<double>   layerStartTimes;  // Start time of each layer within the build
+    std::vector<double>   layerScanTimes;   // Time taken to scan the geometry of each layer
+
+    std::vector<double>   geomStartTimes;   // Start time of each geometry relative to the start of its layer
+    std::vector<double>   geomTimes;        // Time taken to scan each geometry
+    std::vector<uint32_t> geomStyles;       // Dense build style index of each geometry
+
+    bool cacheArcLengths;
+    mutable std::vector<ArcLengthTable::ConstPtr> arcLengthTables; // Accessed atomically
 };
 
 } // end of namespace slm
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cfloat>
+
+#include "ThreadPool.h"
+#include "Statistics.h"
+
+using namespace slm;
+
+LayerStatistics::LayerStatistics() : layerId(0),
+                                     zMin(0),
+                                     zMax(0),
+                                     numPoints(0),
+                                     scanLength(0.0)
+{
+    bbox[0] = FLT_MAX;
+    bbox[1] = -FLT_MAX;
+    bbox[2] = FLT_MAX;
+    bbox[3] = -FLT_MAX;
+
+    for(auto &num : numGeometry)
+        num = 0;
+}
+
+void LayerStatistics::merge(const LayerStatistics &other)
+{
+    bbox[0] = std::min(bbox[0], other.bbox[0]);
+    bbox[1] = std::max(bbox[1], other.bbox[1]);
+    bbox[2] = std::min(bbox[2], other.bbox[2]);
+    bbox[3] = std::max(bbox[3], other.bbox[3]);
+
+    zMin = std::min(zMin, other.zMin);
+    zMax = std::max(zMax, other.zMax);
+    layerId = std::max(layerId, other.layerId);
+
+    for(size_t i = 0; i <= LayerGeometry::PNTS; i++)
+        numGeometry[i] += other.numGeometry[i];
+
+    numPoints  += other.numPoints;
+    scanLength += other.scanLength;
+}
+
+BuildStatistics::BuildStatistics()
+{
+}
+
+BuildStatistics::BuildStatistics(const std::vector<Layer::Ptr> &layers, int numThreads)
+{
+    this->compute(layers, numThreads);
+}
+
+BuildStatistics::~BuildStatistics()
+{
+}
+
+void BuildStatistics::clear()
+{
+    mTotal = LayerStatistics();
+    mLayers.clear();
+}
+
+double BuildStatistics::scanLength(const GeometryView &geom)
+{
+    typedef Eigen::Map<const Eigen::ArrayXf> ColMap;
+    typedef Eigen::Map<const Eigen::ArrayXf, 0, Eigen::InnerStride<2> > StridedColMap;
+
+    const Eigen::Index n = geom.rows;
+
+    if(n < 2 || geom.cols < 2)
+        return 0.0;
+
+    const float *x = geom.data;
+    const float *y = geom.data + n;
+
+    if(geom.type == LayerGeometry::HATCH) {
+
+        // Hatch vectors are formed by consecutive pairs of points
+        const Eigen::Index numVecs = n / 2;
+
+        StridedColMap x0(x, numVecs), x1(x + 1, numVecs);
+        StridedColMap y0(y, numVecs), y1(y + 1, numVecs);
+
+        return ((x1 - x0).square() + (y1 - y0).square()).sqrt().sum();
+
+    } else if(geom.type == LayerGeometry::POLYGON) {
+
+        ColMap xs(x, n), ys(y, n);
+
+        return ((xs.tail(n - 1) - xs.head(n - 1)).square() +
+                (ys.tail(n - 1) - ys.head(n - 1)).square()).sqrt().sum();
+    }
+
+    return 0.0;
+}
+
+LayerStatistics BuildStatistics::computeLayer(const Layer &layer)
+{
+    LayerStatistics stats;
+    stats.layerId = layer.getLayerId();
+    stats.zMin = layer.getZ();
+    stats.zMax = layer.getZ();
+
+    for(auto geom : layer.geometryViews()) {
+
+        int type = geom.type;
+
+        if(type < LayerGeometry::INVALID || type > LayerGeometry::PNTS)
+            type = LayerGeometry::INVALID;
+
+        stats.numGeometry[type]++;
+
+        if(geom.rows == 0 || geom.cols < 2)
+            continue;
+
+        stats.numPoints += geom.rows;
+
+        // Reduce each coordinate column of the geometry in a single vectorised pass
+        Eigen::Map<const Eigen::ArrayXf> xs(geom.data, geom.rows);
+        Eigen::Map<const Eigen::ArrayXf> ys(geom.data + geom.rows, geom.rows);
+
+        stats.bbox[0] = std::min(stats.bbox[0], xs.minCoeff());
+        stats.bbox[1] = std::max(stats.bbox[1], xs.maxCoeff());
+        stats.bbox[2] = std::min(stats.bbox[2], ys.minCoeff());
+        stats.bbox[3] = std::max(stats.bbox[3], ys.maxCoeff());
+
+        stats.scanLength += scanLength(geom);
+    }
+
+    return stats;
+}
+
+void BuildStatistics::compute(const std::vector<Layer::Ptr> &layers, int numThreads)
+{
+    this->clear();
+
+    if(layers.empty())
+        return;
+
+    mLayers.resize(layers.size());
+
+    ThreadPool::instance().parallelFor(layers.size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++)
+            mLayers[i] = computeLayer(*layers[i]);
+    }, 0, numThreads > 0 ? numThreads : 0);
+
+    mTotal = mLayers.front();
+
+    for(size_t i = 1; i < mLayers.size(); i++)
+        mTotal.merge(mLayers[i]);
+}
@@ -0,0 +1,69 @@
+#ifndef SLM_STATISTICS_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_STATISTICS_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "Layer.h"
+
+namespace slm
+{
+
+/**
+ * @brief The LayerStatistics struct summarises the geometry of a layer, or of the entire build once merged
+ */
+struct SLM_EXPORT LayerStatistics
+{
+    LayerStatistics();
+
+    // Combines the statistics of another layer into this
+    void merge(const LayerStatistics &other);
+
+    bool hasGeometry() const { return numPoints > 0; }
+    uint64_t numGeometryByType(LayerGeometry::TYPE type) const { return numGeometry[type]; }
+
+    uint64_t layerId;
+    uint64_t zMin;
+    uint64_t zMax;
+
+    // Bounding box of the geometry in the order minX, maxX, minY, maxY
+    float bbox[4];
+
+    uint64_t numGeometry[LayerGeometry::PNTS + 1]; // Number of geometries for each LayerGeometry::TYPE
+    uint64_t numPoints;    // Number of coordinates across all geometry
+    double   scanLength;   // Total length of the hatch and contour scan vectors
+};
+
+/**
+ * @brief The BuildStatistics class computes the statistics of every layer and of the entire build in a single
+ * traversal of the geometry. Layers are processed concurrently and each geometry is reduced with vectorised Eigen
+ * operations directly on its coordinates.
+ */
+class SLM_EXPORT BuildStatistics
+{
+public:
+    BuildStatistics();
+    BuildStatistics(const std::vector<Layer::Ptr> &layers, int numThreads = 0);
+    ~BuildStatistics();
+
+public:
+    void compute(const std::vector<Layer::Ptr> &layers, int numThreads = 0);
+    void clear();
+
+    const LayerStatistics & total() const { return mTotal; }
+    const std::vector<LayerStatistics> & layers() const { return mLayers; }
+    uint64_t numLayers() const { return mLayers.size(); }
+
+    static LayerStatistics computeLayer(const Layer &layer);
+    static double scanLength(const GeometryView &geom);
+
+protected:
+    LayerStatistics mTotal;
+    std::vector<LayerStatistics> mLayers;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_STATISTICS_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#include "ThreadPool.h"
+
+using namespace slm;
+
+namespace {
+
+// Shared state of a single parallelFor call
+struct ParallelJob
+{
+    std::function<void(size_t, size_t)> func;
+    size_t count;
+    size_t chunkSize;
+
+    std::atomic<size_t> next;
+    size_t completed;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+
+    void runChunks()
+    {
+        size_t begin;
+
+        while((begin = next.fetch_add(chunkSize)) < count) {
+
+            const size_t end = std::min(begin + chunkSize, count);
+
+            try {
+                func(begin, end);
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!error)
+                    error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            completed += end - begin;
+
+            if(completed == count)
+                finished.notify_all();
+        }
+    }
+};
+
+} // End of anonymous namespace
+
+ThreadPool::ThreadPool(size_t numThreads) : mStop(false)
+{
+    if(numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // The calling thread also participates in parallelFor
+    for(size_t i = 0; i + 1 < numThreads; i++)
+        mWorkers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+
+    mCondition.notify_all();
+
+    for(auto &worker : mWorkers)
+        worker.join();
+}
+
+ThreadPool & ThreadPool::instance()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run()
+{
+    while(true) {
+
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]{ return mStop || !mTasks.empty(); });
+
+            if(mStop && mTasks.empty())
+                return;
+
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t, size_t)> &func,
+                             size_t chunkSize,
+                             size_t maxThreads)
+{
+    if(count == 0)
+        return;
+
+    size_t numThreads = mWorkers.size() + 1;
+
+    if(maxThreads > 0)
+        numThreads = std::min(numThreads, maxThreads);
+
+    if(chunkSize == 0)
+        chunkSize = std::max<size_t>(1, count / (numThreads * 4));
+
+    // Run small or serial workloads directly on the calling thread
+    if(numThreads == 1 || count <= chunkSize) {
+        func(0, count);
+        return;
+    }
+
+    std::shared_ptr<ParallelJob> job = std::make_shared<ParallelJob>();
+    job->func = func;
+    job->count = count;
+    job->chunkSize = chunkSize;
+    job->next = 0;
+    job->completed = 0;
+
+    const size_t numHelpers = std::min(numThreads - 1, (count + chunkSize - 1) / chunkSize - 1);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for(size_t i = 0; i < numHelpers; i++)
+            mTasks.emplace_back([job]() { job->runChunks(); });
+    }
+
+    mCondition.notify_all();
+
+    job->runChunks();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job]{ return job->completed == job->count; });
+
+    if(job->error)
+        std::rethrow_exception(job->error);
+}
@@ -0,0 +1,122 @@
+#ifndef SLM_THREADPOOL_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_THREADPOOL_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace slm
+{
+
+/**
+ * @brief The ThreadPool class provides a fixed set of worker threads used by the library for data-parallel work
+ * over layers and geometry.
+ */
+class SLM_EXPORT ThreadPool
+{
+public:
+    ThreadPool(size_t numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+public:
+    size_t numThreads() const { return mWorkers.size(); }
+
+    /**
+     * Runs func(begin, end) over the range [0, count) split into chunks which are distributed dynamically across the
+     * workers and the calling thread. The call blocks until all chunks are complete and rethrows the first exception
+     * raised by func. Calls may be nested from within func.
+     *
+     * @param chunkSize - number of items per chunk, 0 chooses a size based on the number of threads
+     * @param maxThreads - limits the number of threads used including the calling thread, 0 uses all workers
+     */
+    void parallelFor(size_t count,
+                     const std::function<void(size_t, size_t)> &func,
+                     size_t chunkSize = 0,
+                     size_t maxThreads = 0);
+
+    /**
+     * Replaces each value with the sum of the values before it, returning the total. The values are split into one
+     * block per thread, which are summed concurrently before each block is scanned from the sum of preceding blocks.
+     *
+     * @param maxThreads - limits the number of threads used including the calling thread, 0 uses all workers
+     */
+    template <class T>
+    T exclusiveScan(T *values, size_t count, size_t maxThreads = 0);
+
+    // Shared pool sized to the hardware concurrency
+    static ThreadPool & instance();
+
+private:
+    void run();
+
+    std::vector<std::thread> mWorkers;
+    std::deque<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStop;
+};
+
+template <class T>
+T ThreadPool::exclusiveScan(T *values, size_t count, size_t maxThreads)
+{
+    // Blocks are large enough that the scan is not dominated by scheduling
+    const size_t minBlockSize = 4096;
+
+    size_t numBlocks = mWorkers.size() + 1;
+
+    if(maxThreads > 0)
+        numBlocks = std::min(numBlocks, maxThreads);
+
+    numBlocks = std::max<size_t>(1, std::min(numBlocks, count / minBlockSize));
+
+    const size_t blockSize = (count + numBlocks - 1) / std::max<size_t>(1, numBlocks);
+
+    std::vector<T> blockSums(numBlocks + 1, T());
+
+    parallelFor(numBlocks, [&](size_t begin, size_t end) {
+
+        for(size_t b = begin; b < end; b++) {
+
+            T sum = T();
+
+            for(size_t i = b * blockSize; i < std::min(count, (b + 1) * blockSize); i++)
+                sum += values[i];
+
+            blockSums[b + 1] = sum;
+        }
+
+    }, 1, maxThreads);
+
+    for(size_t b = 0; b < numBlocks; b++)
+        blockSums[b + 1] += blockSums[b];
+
+    parallelFor(numBlocks, [&](size_t begin, size_t end) {
+
+        for(size_t b = begin; b < end; b++) {
+
+            T sum = blockSums[b];
+
+            for(size_t i = b * blockSize; i < std::min(count, (b + 1) * blockSize); i++) {
+                const T value = values[i];
+                values[i] = sum;
+                sum += value;
+            }
+        }
+
+    }, 1, maxThreads);
+
+    return blockSums[numBlocks];
+}
+
+} // End of Namespace slm
+
+#endif // SLM_THREADPOOL_H_HEADER_HAS_BEEN_INCLUDED
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <sstream>
+#include <unordered_set>
+
+#include "ThreadPool.h"
+#include "Validator.h"
+
+using namespace slm;
+
+namespace {
+
+// Key of a build style within the set of build styles of all models
+uint64_t buildStyleKey(uint64_t mid, uint64_t bid)
+{
+    return (mid << 32) | (bid & 0xFFFFFFFF);
+}
+
+} // End of anonymous namespace
+
+std::string ValidationIssue::message() const
+{
+    std::ostringstream str;
+    str << "Layer " << layerId << " (" << layerIdx << ")";
+
+    if(geometryIdx >= 0)
+        str << " geometry " << geometryIdx;
+
+    str << ": " << Validator::codeName(code);
+
+    return str.str();
+}
+
+Validator::Validator()
+{
+}
+
+Validator::~Validator()
+{
+}
+
+void Validator::clear()
+{
+    mIssues.clear();
+}
+
+std::string Validator::codeName(ValidationIssue::CODE code)
+{
+    switch(code) {
+        case ValidationIssue::NON_FINITE_COORDINATE: return "non-finite coordinate";
+        case ValidationIssue::ODD_HATCH_POINTS:      return "hatch with an odd number of points";
+        case ValidationIssue::MISSING_MODEL:         return "missing model";
+        case ValidationIssue::MISSING_BUILD_STYLE:   return "missing build style";
+        case ValidationIssue::NON_MONOTONIC_Z:       return "non-monotonic z";
+        case ValidationIssue::DUPLICATE_LAYER_ID:    return "duplicate layer id";
+    }
+
+    return "unknown";
+}
+
+uint64_t Validator::numIssuesByCode(ValidationIssue::CODE code) const
+{
+    return std::count_if(mIssues.begin(), mIssues.end(), [code](const ValidationIssue &issue) {
+        return issue.code == code;
+    });
+}
+
+bool Validator::validate(const std::vector<Model::Ptr> &models, const std::vector<Layer::Ptr> &layers, int numThreads)
+{
+    this->clear();
+
+    // Lookup tables of the model and build style ids referenced by the geometry
+    std::unordered_set<uint64_t> modelIds;
+    std::unordered_set<uint64_t> buildStyleIds;
+
+    for(auto model : models) {
+
+        modelIds.insert(model->getId());
+
+        for(auto bstyle : model->getBuildStyles())
+            buildStyleIds.insert(buildStyleKey(model->getId(), bstyle->id));
+    }
+
+    // The geometry of each layer is checked independently, with the issues collected separately for each layer
+    std::vector<std::vector<ValidationIssue> > layerIssues(layers.size());
+
+    // A number of threads of 0 or less uses all available threads
+    const size_t maxThreads = numThreads > 0 ? static_cast<size_t>(numThreads) : 0;
+
+    ThreadPool::instance().parallelFor(layers.size(), [&](size_t begin, size_t end) {
+
+        for(size_t i = begin; i < end; i++) {
+
+            const Layer &layer = *layers[i];
+            std::vector<ValidationIssue> &issues = layerIssues[i];
+
+            const uint64_t id = layer.getLayerId();
+            int64_t geomIdx = 0;
+
+            for(auto geom : layer.geometryViews()) {
+
+                if(geom.rows > 0 && !geom.coords().allFinite())
+                    issues.push_back(ValidationIssue(ValidationIssue::NON_FINITE_COORDINATE, i, id, geomIdx));
+
+                if(geom.type == LayerGeometry::HATCH && geom.rows % 2 != 0)
+                    issues.push_back(ValidationIssue(ValidationIssue::ODD_HATCH_POINTS, i, id, geomIdx));
+
+                if(modelIds.find(geom.mid) == modelIds.end())
+                    issues.push_back(ValidationIssue(ValidationIssue::MISSING_MODEL, i, id, geomIdx));
+                else if(buildStyleIds.find(buildStyleKey(geom.mid, geom.bid)) == buildStyleIds.end())
+                    issues.push_back(ValidationIssue(ValidationIssue::MISSING_BUILD_STYLE, i, id, geomIdx));
+
+                geomIdx++;
+            }
+        }
+
+    }, 0, maxThreads);
+
+    // The ordering of the layers is checked afterwards, reporting the issues of each layer before its geometry
+    std::unordered_set<uint64_t> layerIds;
+    layerIds.reserve(layers.size());
+
+    for(size_t i = 0; i < layers.size(); i++) {
+
+        const Layer &layer = *layers[i];
+
+        if(i > 0 && layer.getZ() <= layers[i - 1]->getZ())
+            mIssues.push_back(ValidationIssue(ValidationIssue::NON_MONOTONIC_Z, i, layer.getLayerId()));
+
+        if(!layerIds.insert(layer.getLayerId()).second)
+            mIssues.push_back(ValidationIssue(ValidationIssue::DUPLICATE_LAYER_ID, i, layer.getLayerId()));
+
+        mIssues.insert(mIssues.end(), layerIssues[i].begin(), layerIssues[i].end());
+    }
+
+    return mIssues.empty();
+}
@@ -0,0 +1,78 @@
+#ifndef SLM_VALIDATOR_H_HEADER_HAS_BEEN_INCLUDED
+#define SLM_VALIDATOR_H_HEADER_HAS_BEEN_INCLUDED
+
+#include "SLM_Export.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Layer.h"
+#include "Model.h"
+
+namespace slm
+{
+
+/**
+ * @brief The ValidationIssue struct describes a single problem found within a build by the Validator
+ */
+struct SLM_EXPORT ValidationIssue
+{
+    enum CODE
+    {
+        NON_FINITE_COORDINATE = 0, // A coordinate of the geometry is NaN or infinite
+        ODD_HATCH_POINTS,          // A hatch geometry has an odd number of points
+        MISSING_MODEL,             // The model id of the geometry is not within the models
+        MISSING_BUILD_STYLE,       // The build style id of the geometry is not within its model
+        NON_MONOTONIC_Z,           // The z position does not increase from the previous layer
+        DUPLICATE_LAYER_ID         // The layer id is used by a previous layer
+    };
+
+    ValidationIssue() : code(NON_FINITE_COORDINATE), layerIdx(0), layerId(0), geometryIdx(-1) {}
+    ValidationIssue(CODE issueCode, uint64_t idx, uint64_t id, int64_t geomIdx = -1) : code(issueCode),
+                                                                                       layerIdx(idx),
+                                                                                       layerId(id),
+                                                                                       geometryIdx(geomIdx) {}
+
+    std::string message() const;
+
+    CODE     code;
+    uint64_t layerIdx;    // Position of the layer within the build
+    uint64_t layerId;
+    int64_t  geometryIdx; // Index of the geometry within the layer or -1 for issues of the layer itself
+};
+
+/**
+ * @brief The Validator class checks a build for problems which would otherwise only be found when writing the build
+ * or on the machine. The geometry of the layers is checked concurrently, whilst the ordering of the layers is checked
+ * afterwards. The issues are reported in the order of the layers and their geometry.
+ */
+class SLM_EXPORT Validator
+{
+public:
+    Validator();
+    ~Validator();
+
+public:
+    /**
+     * Validates the models and layers of a build
+     * @param numThreads The number of threads used to check the geometry of the layers, 0 or less uses all threads
+     * @return true if no issues were found
+     */
+    bool validate(const std::vector<Model::Ptr> &models, const std::vector<Layer::Ptr> &layers, int numThreads = 0);
+    void clear();
+
+    bool isValid() const { return mIssues.empty(); }
+    const std::vector<ValidationIssue> & issues() const { return mIssues; }
+    uint64_t numIssues() const { return mIssues.size(); }
+    uint64_t numIssuesByCode(ValidationIssue::CODE code) const;
+
+    static std::string codeName(ValidationIssue::CODE code);
+
+protected:
+    std::vector<ValidationIssue> mIssues;
+};
+
+} // End of Namespace slm
+
+#endif // SLM_VALIDATOR_H_HEADER_HAS_BEEN_INCLUDED
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
@@ -5,6 +6,9 @@
 #include <filesystem/resolver.h>
 #include <filesystem/path.h>
 
+#include "Build.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
 #include "Writer.h"
 
 namespace fs = filesystem;
@@ -13,18 +17,28 @@ using namespace slm;
 using namespace base;
 
 Writer::Writer(const char * fname) : ready(false),
-                                     mSortLayers(false)
+                                     mSortLayers(false),
+                                     mStreaming(false),
+                                     mWriteFailed(false),
+                                     mNumThreads(0)
 {
     this->setFilePath(std::string(fname));
 }
 
 Writer::Writer(const std::string &fname) : ready(false),
-                                           mSortLayers(false)
+                                           mSortLayers(false),
+                                           mStreaming(false),
+                                           mWriteFailed(false),
+                                           mNumThreads(0)
 {
     this->setFilePath(fname);
 }
 
-Writer::Writer() : ready(false)
+Writer::Writer() : ready(false),
+                   mSortLayers(false),
+                   mStreaming(false),
+                   mWriteFailed(false),
+                   mNumThreads(0)
 {
 }
 
@@ -42,45 +56,193 @@ void Writer::getFileHandle(std::fstream &file) const
     }
 }
 
-void Writer::setFilePath(const std::string &path)
+int Writer::begin(const Header &header, const std::vector<Model::Ptr> &models)
 {
-    this->setReady(true);
-    this->filePath = path;
-    std::cout << "File '" << path << "' is ready to write" << std::endl;
+    if(!this->isReady()) {
+        std::cerr << "File is not ready for writing" << std::endl;
+        return -1;
+    }
+
+    if(mStreaming) {
+        std::cerr << "Writer - begin() called before the previous build was finished" << std::endl;
+        return -1;
+    }
+
+    mTotals = WriterTotals();
+
+    if(this->beginStream(header, models) < 0)
+        return -1;
+
+    mStreaming = true;
+
+    return 1;
 }
 
-Layer::Ptr Writer::getTopLayerByPosition(const std::vector<Layer::Ptr> &layers)
+int Writer::appendLayer(const Layer::Ptr &layer)
 {
-    uint64_t zMax = 0;
+    if(!mStreaming) {
+        std::cerr << "Writer - appendLayer() called before begin()" << std::endl;
+        return -1;
+    }
 
-    Layer::Ptr fndLayer;
+    if(!layer)
+        return -1;
 
-    for(auto layer : layers) {
+    if(this->writeStreamLayer(layer) < 0)
+        return -1;
 
-        if(layer->getZ() > zMax) {
-            fndLayer = layer;
-            zMax = layer->getZ();
-        }
+    // Accumulate the totals which may be required by the header or trailing tables of the file
+    if(mTotals.numLayers == 0) {
+        mTotals.zMin = layer->getZ();
+        mTotals.zMax = layer->getZ();
     }
 
-    return fndLayer;
+    const LayerStatistics stats = BuildStatistics::computeLayer(*layer);
+
+    mTotals.zMin = std::min(mTotals.zMin, stats.zMin);
+    mTotals.zMax = std::max(mTotals.zMax, stats.zMax);
+    mTotals.topLayerId = std::max(mTotals.topLayerId, stats.layerId);
+    mTotals.numLayers++;
+
+    mTotals.numHatches  += stats.numGeometryByType(LayerGeometry::HATCH);
+    mTotals.numContours += stats.numGeometryByType(LayerGeometry::POLYGON);
+    mTotals.numPoints   += stats.numGeometryByType(LayerGeometry::PNTS);
+
+    if(stats.hasGeometry()) {
+        mTotals.bbox[0] = std::min(mTotals.bbox[0], stats.bbox[0]);
+        mTotals.bbox[1] = std::max(mTotals.bbox[1], stats.bbox[1]);
+        mTotals.bbox[2] = std::min(mTotals.bbox[2], stats.bbox[2]);
+        mTotals.bbox[3] = std::max(mTotals.bbox[3], stats.bbox[3]);
+    }
+
+    return 1;
 }
 
-Layer::Ptr Writer::getTopLayerById(const std::vector<Layer::Ptr> &layers)
+int Writer::finish()
+{
+    if(!mStreaming) {
+        std::cerr << "Writer - finish() called before begin()" << std::endl;
+        return -1;
+    }
+
+    mStreaming = false;
+
+    // A build without geometry has a bounding box of zeros rather than the sentinels used whilst accumulating
+    if(mTotals.bbox[0] > mTotals.bbox[1]) {
+        for(int i = 0; i < 4; i++)
+            mTotals.bbox[i] = 0.0f;
+    }
+
+    return this->finishStream();
+}
+
+int Writer::beginStream(const Header &header, const std::vector<Model::Ptr> &models)
+{
+    mStreamHeader = header;
+    mStreamModels = models;
+    mStreamLayers.clear();
+
+    return 1;
+}
+
+int Writer::writeStreamLayer(const Layer::Ptr &layer)
+{
+    mStreamLayers.push_back(layer);
+    return 1;
+}
+
+int Writer::finishStream()
+{
+    mWriteFailed = false;
+
+    this->write(mStreamHeader, mStreamModels, mStreamLayers);
+
+    mStreamModels.clear();
+    mStreamLayers.clear();
+
+    return mWriteFailed ? -1 : 1;
+}
+
+void Writer::recordLayerOffset(const Layer &layer, uint64_t offset, uint64_t length)
+{
+    LayerIndexEntry entry;
+    entry.layerId = layer.getLayerId();
+    entry.z = layer.getZ();
+    entry.offset = offset;
+    entry.length = length;
+
+    mTotals.layerOffsets.push_back(entry);
+}
+
+int Writer::encodeLayer(const Layer &layer, std::vector<char> &buffer) const
+{
+    return -1;
+}
+
+int64_t Writer::writeLayersParallel(std::ostream &file, const std::vector<Layer::Ptr> &layers)
 {
-    uint64_t zId = 0;
+    ThreadPool &pool = ThreadPool::instance();
+
+    const size_t numThreads = mNumThreads > 0 ? mNumThreads : pool.numThreads() + 1;
+    const size_t batchSize = std::max<size_t>(64, numThreads * 8);
+
+    std::vector<std::vector<char>> buffers;
+    std::vector<int> status;
+
+    uint64_t offset = static_cast<uint64_t>(file.tellp());
+    const uint64_t startOffset = offset;
+
+    for(size_t batchStart = 0; batchStart < layers.size(); batchStart += batchSize) {
+
+        const size_t batchEnd = std::min(batchStart + batchSize, layers.size());
+        const size_t numBatch = batchEnd - batchStart;
+
+        buffers.assign(numBatch, std::vector<char>());
+        status.assign(numBatch, -1);
+
+        // Encode each layer of the batch independently into its own buffer
+        pool.parallelFor(numBatch, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++)
+                status[i] = this->encodeLayer(*layers[batchStart + i], buffers[i]);
+        }, 1, mNumThreads > 0 ? mNumThreads : 0);
 
-    Layer::Ptr fndLayer;
+        // Commit the buffers in order, where the offset of each layer is the prefix sum of the preceding sizes
+        for(size_t i = 0; i < numBatch; i++) {
 
-    for(auto layer : layers) {
+            if(status[i] < 0) {
+                std::cerr << "Writer - failed to encode layer " << layers[batchStart + i]->getLayerId() << std::endl;
+                return -1;
+            }
 
-        if(layer->getLayerId() > zId) {
-            fndLayer = layer;
-            zId = layer->getLayerId();
+            const std::vector<char> &buffer = buffers[i];
+
+            file.write(buffer.data(), buffer.size());
+            this->recordLayerOffset(*layers[batchStart + i], offset, buffer.size());
+            offset += buffer.size();
         }
+
+        if(!file.good())
+            return -1;
     }
 
-    return fndLayer;
+    return offset - startOffset;
+}
+
+void Writer::setFilePath(const std::string &path)
+{
+    this->setReady(true);
+    this->filePath = path;
+    std::cout << "File '" << path << "' is ready to write" << std::endl;
+}
+
+Layer::Ptr Writer::getTopLayerByPosition(const std::vector<Layer::Ptr> &layers)
+{
+    return Build::getTopLayerByPosition(layers);
+}
+
+Layer::Ptr Writer::getTopLayerById(const std::vector<Layer::Ptr> &layers)
+{
+    return Build::getTopLayerById(layers);
 }
 
 std::vector<Layer::Ptr> Writer::sortLayers(const std::vector<Layer::Ptr> &layers)
@@ -107,73 +269,37 @@ int64_t Writer::getTotalNumContours(const std::vector<Layer::Ptr> &layers)
 
 void Writer::getLayerBoundingBox(float *bbox, Layer::Ptr layer)
 {
-    float minX = 1e9, minY = 1e9 , maxX = -1e9, maxY = -1e9;
+    const LayerStatistics stats = BuildStatistics::computeLayer(*layer);
 
-    for(auto geom : layer->geometry()) {
-        auto minCols = geom->coords.colwise().minCoeff();
-        auto maxCols = geom->coords.colwise().maxCoeff();
-
-        if(minCols[0, 0] < minX)
-            minX = minCols[0,0];
-
-        if(minCols[0,1] < minY)
-            minY = minCols[0,1];
-
-        if(maxCols[0,0] > maxX)
-            maxX = maxCols[0,0];
-
-        if(maxCols[0,1] > maxY)
-            maxY = maxCols[0,1];
-    }
+    Writer::copyBoundingBox(bbox, stats);
 }
 
 void Writer::getBoundingBox(float *bbox, const std::vector<Layer::Ptr> &layers)
 {
-    float minX = 1e9, minY = 1e9 , maxX = -1e9, maxY = -1e9;
+    const BuildStatistics stats(layers);
 
-    for (auto layer: layers) {
-        for(auto geom : layer->geometry()) {
-            auto minCols = geom->coords.colwise().minCoeff();
-            auto maxCols = geom->coords.colwise().maxCoeff();
-
-            if(minCols[0, 0] < minX)
-                minX = minCols[0,0];
-
-            if(minCols[0,1] < minY)
-                minY = minCols[0,1];
-
-            if(maxCols[0,0] > maxX)
-                maxX = maxCols[0,0];
-
-            if(maxCols[0,1] > maxY)
-                maxY = maxCols[0,1];
-
-        }
-    }
-
-    bbox[0] = minX;
-    bbox[1] = maxX;
-    bbox[2] = minY;
-    bbox[3] = maxY;
+    Writer::copyBoundingBox(bbox, stats.total());
 }
 
 std::tuple<float, float> Writer::getLayerMinMax(const std::vector<slm::Layer::Ptr> &layers)
 {
-    float zMin = 0.0;
-    float zMax = 0.0;
-    float zPos = 0.0;
-
-    for (auto layer : layers) {
+    // An empty set of layers has a range of zero
+    const BuildStatistics stats(layers);
 
-        zPos = layer->getZ();
+    return std::make_tuple(float(stats.total().zMin), float(stats.total().zMax));
+}
 
-        if(zPos < zMin)
-            zMin = zPos;
+void Writer::copyBoundingBox(float *bbox, const LayerStatistics &stats)
+{
+    // Layers without geometry have an empty bounding box of zeros, rather than sentinels written into headers
+    if(!stats.hasGeometry()) {
+        for(int i = 0; i < 4; i++)
+            bbox[i] = 0.0f;
 
-        if(zPos > zMax)
-            zMax = zPos;
+        return;
     }
 
-    return std::make_tuple(zMin, zMax);
+    for(int i = 0; i < 4; i++)
+        bbox[i] = stats.bbox[i];
 }
 
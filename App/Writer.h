@@ -3,21 +3,45 @@
 
 #include "SLM_Export.h"
 
+#include <fstream>
 #include <string>
 
 #include "Header.h"
 #include "Layer.h"
 #include "Model.h"
+#include "Statistics.h"
 
 namespace slm
 {
 
+/**
+ * @brief The WriterTotals struct accumulates the totals of the layers written incrementally by a Writer
+ */
+struct WriterTotals
+{
+    uint64_t numLayers   = 0;
+    uint64_t numHatches  = 0;
+    uint64_t numContours = 0;
+    uint64_t numPoints   = 0;
+    uint64_t zMin = 0;
+    uint64_t zMax = 0;
+    uint64_t topLayerId = 0;
+
+    // Bounding box of the geometry in the order minX, maxX, minY, maxY, which is zero after finish() if empty
+    float bbox[4] = {1e9, -1e9, 1e9, -1e9};
+
+    // Location of each layer record written to the file
+    std::vector<LayerIndexEntry> layerOffsets;
+};
+
 namespace base
 {
 
 class SLM_EXPORT Writer
 {
 public:
+    typedef std::shared_ptr<Writer> Ptr;
+
     Writer(const char *fileLoc);
     Writer(const std::string &fileLoc);
     Writer();
@@ -37,7 +61,29 @@ public:
     bool isSortingLayers() const { return mSortLayers; }
     void setSortLayers(bool state) { mSortLayers = state; }
 
+    /*
+     * Incremental writing. The build is written by calling begin() once, appendLayer() for each layer in the order
+     * of the file and finally finish(). Writers that override beginStream, writeStreamLayer and finishStream write
+     * each layer as it is appended. The base implementation is not streaming: the layers are retained until finish()
+     * and passed to write(), so the memory used grows with the build. finish() returns -1 if write() reported a
+     * failure with setWriteFailed().
+     */
+    int begin(const Header &header, const std::vector<Model::Ptr> &models);
+    int appendLayer(const Layer::Ptr &layer);
+    int finish();
+
+    // Whether the last call to write() failed, for writers which report failures with setWriteFailed()
+    bool hasWriteFailed() const { return mWriteFailed; }
+
+    bool isStreaming() const { return mStreaming; }
+    const WriterTotals & totals() const { return mTotals; }
+
+    // Number of threads used for encoding layers, 0 uses all available threads
+    void setNumThreads(int num) { mNumThreads = num; }
+    int numThreads() const { return mNumThreads; }
+
 public:
+     // Bounding box in the order minX, maxX, minY, maxY, which is zero when the layers have no geometry
      static void getBoundingBox(float *bbox, const std::vector<Layer::Ptr> &layers);
      static void getLayerBoundingBox(float *bbox, Layer::Ptr layer);
      static std::tuple<float, float> getLayerMinMax(const std::vector<slm::Layer::Ptr> &layers);
@@ -54,21 +100,70 @@ public:
          int64_t numGeomT = 0;
 
          for(auto layer : layers)
-             numGeomT += layer->getGeometryByType<T>().size();
+             numGeomT += layer->numGeometryByType(T::type);
 
          return numGeomT;
      }
 
 protected:
+    static void copyBoundingBox(float *bbox, const LayerStatistics &stats);
+
     void setReady(bool state) { ready = state; }
+    void setWriteFailed(bool state) { mWriteFailed = state; }
     void getFileHandle(std::fstream &file) const;
-    
+
+    virtual int beginStream(const Header &header, const std::vector<Model::Ptr> &models);
+    virtual int writeStreamLayer(const Layer::Ptr &layer);
+    virtual int finishStream();
+
+    // Records the location of a layer record written to the file in the totals
+    void recordLayerOffset(const Layer &layer, uint64_t offset, uint64_t length);
+    void resetTotals() { mTotals = WriterTotals(); }
+
+    /**
+     * Encodes a single layer record into a buffer independently of the other layers. This is called concurrently
+     * for different layers by writeLayersParallel.
+     * @return 1 on success or -1 on failure
+     */
+    virtual int encodeLayer(const Layer &layer, std::vector<char> &buffer) const;
+
+    /**
+     * Encodes the layers concurrently using encodeLayer and writes the buffers in order at the current position of
+     * the file. The offset of each layer record follows from the prefix sum of the buffer sizes and is recorded with
+     * recordLayerOffset. Layers are encoded in batches so that only a limited number of buffers are held at once.
+     * @return The number of bytes written or -1 on failure
+     */
+    int64_t writeLayersParallel(std::ostream &file, const std::vector<Layer::Ptr> &layers);
+
+    /**
+     * Overwrites a value at a previously reserved position of the file, e.g. header fields which require the totals
+     * of the build, and restores the write position afterwards.
+     */
+    template <class T>
+    static void patchValue(std::ostream &file, uint64_t pos, const T &value)
+    {
+        const std::streampos curPos = file.tellp();
+        file.seekp(pos);
+        file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        file.seekp(curPos);
+    }
+
 protected:
     std::string filePath;
 
 private:
     bool ready;
     bool mSortLayers;
+    bool mStreaming;
+    bool mWriteFailed;
+    int mNumThreads;
+
+    WriterTotals mTotals;
+
+    // Used by the default incremental writing which defers to write()
+    Header mStreamHeader;
+    std::vector<Model::Ptr> mStreamModels;
+    std::vector<Layer::Ptr> mStreamLayers;
 };
 
 } // End of Namespace Base
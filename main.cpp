@@ -1,99 +1,207 @@
-#include <math.h>
-#include <iostream>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iostream>
 #include <string>
+#include <vector>
 
-int main(int argc, char *argv[])
+#include <App/FormatRegistry.h>
+#include <App/Header.h>
+#include <App/NativeReader.h>
+#include <App/Reader.h>
+#include <App/Writer.h>
+
+namespace {
+
+// Modes processed line by line when no translator of the same name is registered
+const char *LegacyModes[] = {"mtt", "realizer", "eos"};
+
+// Z unit written to the output header when it is neither given nor provided by the input build
+const int DefaultZUnit = 1000;
+
+void printUsage(const char *program)
 {
-    if(argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <mode> <input_file> [output_file]" << std::endl;
-        std::cerr << "Modes: mtt, realizer, eos" << std::endl;
-        return 1;
+    std::cerr << "Usage: " << program << " [mode] <input_file> [output_file] [--zunit <value>]" << std::endl;
+    std::cerr << "Formats:";
+
+    for(const std::string &name : slm::FormatRegistry::instance().formatNames())
+        std::cerr << " " << name;
+
+    std::cerr << std::endl;
+    std::cerr << "Modes: the name of a format, or mtt, realizer, eos" << std::endl;
+}
+
+// Parses a positive z unit, rejecting any value which is not entirely a number within range
+bool parseZUnit(const char *str, int &zUnit)
+{
+    char *end = nullptr;
+
+    errno = 0;
+    const long value = std::strtol(str, &end, 10);
+
+    if(end == str || *end != '\0' || errno == ERANGE || value <= 0 || value > INT_MAX)
+        return false;
+
+    zUnit = static_cast<int>(value);
+
+    return true;
+}
+
+bool isLegacyMode(const std::string &mode)
+{
+    for(const char *legacyMode : LegacyModes) {
+        if(mode == legacyMode)
+            return true;
     }
-    
-    std::string mode = argv[1];
-    std::string inputFilename = argv[2];
-    std::string outputFilename = (argc > 3) ? argv[3] : "output.txt";
-    
-    std::cout << "Processing file: " << inputFilename << std::endl;
-    std::cout << "Mode: " << mode << std::endl;
-    
-    // Check if input file exists
+
+    return false;
+}
+
+int processLegacy(const std::string &mode, const std::string &inputFilename, const std::string &outputFilename)
+{
     std::ifstream inputFile(inputFilename);
-    if (!inputFile.is_open()) {
+
+    if(!inputFile.is_open()) {
         std::cerr << "Error: Cannot open input file " << inputFilename << std::endl;
         return 1;
     }
-    
-    // Basic file processing based on mode
-    if(mode == "mtt") {
-        std::cout << "Processing MTT file..." << std::endl;
-        
-        // Read input file
-        std::string line;
-        std::ofstream outputFile(outputFilename);
-        
-        if (!outputFile.is_open()) {
-            std::cerr << "Error: Cannot create output file " << outputFilename << std::endl;
-            inputFile.close();
-            return 1;
-        }
-        
-        // Simple copy/processing
-        outputFile << "# MTT Processing Output" << std::endl;
-        while (std::getline(inputFile, line)) {
-            outputFile << "MTT: " << line << std::endl;
-        }
-        
-        outputFile.close();
-        std::cout << "MTT processing complete. Output written to " << outputFilename << std::endl;
-        
-    } else if(mode == "realizer") {
-        std::cout << "Processing Realizer file..." << std::endl;
-        
-        std::string line;
-        std::ofstream outputFile(outputFilename);
-        
-        if (!outputFile.is_open()) {
-            std::cerr << "Error: Cannot create output file " << outputFilename << std::endl;
-            inputFile.close();
-            return 1;
-        }
-        
-        outputFile << "# Realizer Processing Output" << std::endl;
-        while (std::getline(inputFile, line)) {
-            outputFile << "REALIZER: " << line << std::endl;
-        }
-        
-        outputFile.close();
-        std::cout << "Realizer processing complete. Output written to " << outputFilename << std::endl;
-        
-    } else if(mode == "eos") {
-        std::cout << "Processing EOS file..." << std::endl;
-        
-        std::string line;
-        std::ofstream outputFile(outputFilename);
-        
-        if (!outputFile.is_open()) {
-            std::cerr << "Error: Cannot create output file " << outputFilename << std::endl;
-            inputFile.close();
-            return 1;
-        }
-        
-        outputFile << "# EOS Processing Output" << std::endl;
-        while (std::getline(inputFile, line)) {
-            outputFile << "EOS: " << line << std::endl;
+
+    std::ofstream outputFile(outputFilename);
+
+    if(!outputFile.is_open()) {
+        std::cerr << "Error: Cannot create output file " << outputFilename << std::endl;
+        return 1;
+    }
+
+    std::string prefix = mode;
+
+    for(char &c : prefix)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+    std::cout << "Processing " << mode << " file..." << std::endl;
+
+    std::string line;
+    outputFile << "# " << mode << " Processing Output" << std::endl;
+
+    while(std::getline(inputFile, line))
+        outputFile << prefix << ": " << line << std::endl;
+
+    std::cout << mode << " processing complete. Output written to " << outputFilename << std::endl;
+
+    return 0;
+}
+
+} // End of anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> args;
+    int zUnitArg = 0;
+
+    for(int i = 1; i < argc; i++) {
+
+        if(std::strcmp(argv[i], "--zunit") == 0) {
+
+            if(i + 1 >= argc || !parseZUnit(argv[++i], zUnitArg)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+
+            continue;
         }
-        
-        outputFile.close();
-        std::cout << "EOS processing complete. Output written to " << outputFilename << std::endl;
-        
-    } else {
-        std::cerr << "Error: Invalid mode '" << mode << "'. Valid modes are: mtt, realizer, eos" << std::endl;
-        inputFile.close();
+
+        args.push_back(argv[i]);
+    }
+
+    if(args.empty() || args.size() > 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    slm::FormatRegistry &registry = slm::FormatRegistry::instance();
+    slm::FormatInfo format;
+
+    // An explicit mode is given when the first argument names a format
+    std::string mode;
+
+    if(args.size() > 1 && (registry.findFormat(args[0], format) || isLegacyMode(args[0]))) {
+        mode = args[0];
+        args.erase(args.begin());
+    }
+
+    const std::string inputFilename = args[0];
+    const std::string outputFilename = (args.size() > 1) ? args[1] : "";
+
+    std::cout << "Processing file: " << inputFilename << std::endl;
+
+    if(!mode.empty()) {
+
+        std::cout << "Mode: " << mode << std::endl;
+
+        // Modes without a registered translator fall back to processing the file line by line
+        if(format.name != mode)
+            return processLegacy(mode, inputFilename, outputFilename.empty() ? "output.txt" : outputFilename);
+
+    } else if(!registry.detectFormat(inputFilename, format)) {
+        // The format of the build is detected from the contents of the file
+        std::cerr << "Error: Unknown build format of input file " << inputFilename << std::endl;
         return 1;
     }
-    
-    inputFile.close();
+
+    std::cout << "Format: " << format.name << std::endl;
+
+    slm::base::Reader::Ptr reader = format.createReader ? format.createReader() : slm::base::Reader::Ptr();
+
+    if(!reader) {
+        std::cerr << "Error: The format " << format.name << " cannot be read" << std::endl;
+        return 1;
+    }
+
+    reader->setFilePath(inputFilename);
+
+    if(reader->parse() < 0) {
+        std::cerr << "Error: Cannot parse input file " << inputFilename << std::endl;
+        return 1;
+    }
+
+    const slm::BuildSummary summary = reader->getSummary();
+
+    std::cout << "Models: " << summary.numModels << std::endl;
+    std::cout << "Layers: " << summary.numLayers << std::endl;
+    std::cout << "Z Range: " << summary.zMin << " - " << summary.zMax << std::endl;
+    std::cout << "Layer Thickness: " << summary.layerThickness << std::endl;
+
+    if(outputFilename.empty())
+        return 0;
+
+    // The output format is chosen by the extension of the output file
+    slm::base::Writer::Ptr writer = registry.createWriter(outputFilename);
+
+    if(!writer) {
+        std::cerr << "Error: No writer for the format of output file " << outputFilename << std::endl;
+        return 1;
+    }
+
+    slm::Header header;
+    header.fileName = inputFilename;
+    header.creator = "libSLM";
+    header.setVersion(std::make_tuple(1, 0));
+    header.zUnit = DefaultZUnit;
+
+    // The z unit given takes precedence over the z unit of the input build, where a z unit of 0 is unknown
+    const slm::NativeReader *nativeReader = dynamic_cast<const slm::NativeReader *>(reader.get());
+
+    if(zUnitArg > 0)
+        header.zUnit = zUnitArg;
+    else if(nativeReader && nativeReader->getHeader().zUnit > 0)
+        header.zUnit = nativeReader->getHeader().zUnit;
+
+    writer->write(header, reader->getModels(), reader->getLayers());
+
+    std::cout << "Output written to " << outputFilename << std::endl;
+
     return 0;
 }
@@ -11,10 +11,19 @@
 
 #include <tuple>
 
+#include <App/Build.h>
+#include <App/BuildCache.h>
+#include <App/BuildStyleTable.h>
+#include <App/GeometryStore.h>
 #include <App/Header.h>
 #include <App/Layer.h>
 #include <App/Model.h>
+#include <App/NativeReader.h>
+#include <App/NativeWriter.h>
 #include <App/Reader.h>
+#include <App/Slm.h>
+#include <App/Statistics.h>
+#include <App/Validator.h>
 #include <App/Writer.h>
 
 #include "utils.h"
@@ -85,14 +94,63 @@ PYBIND11_MODULE(slm, m) {
 
     };
 
+    py::class_<slm::BuildSummary>(m, "BuildSummary")
+        .def(py::init())
+        .def_readonly("numLayers", &slm::BuildSummary::numLayers)
+        .def_readonly("numModels", &slm::BuildSummary::numModels)
+        .def_readonly("zMin", &slm::BuildSummary::zMin)
+        .def_readonly("zMax", &slm::BuildSummary::zMax)
+        .def_readonly("topLayerId", &slm::BuildSummary::topLayerId)
+        .def_readonly("layerThickness", &slm::BuildSummary::layerThickness);
+
+    py::class_<slm::LayerFilter>(m, "LayerFilter")
+        .def(py::init())
+        .def_readwrite("layerIdMin", &slm::LayerFilter::layerIdMin)
+        .def_readwrite("layerIdMax", &slm::LayerFilter::layerIdMax)
+        .def_readwrite("zMin", &slm::LayerFilter::zMin)
+        .def_readwrite("zMax", &slm::LayerFilter::zMax)
+        .def_readwrite("modelIds", &slm::LayerFilter::modelIds)
+        .def("setLayerIdRange", &slm::LayerFilter::setLayerIdRange, py::arg("first"), py::arg("last"))
+        .def("setZRange", &slm::LayerFilter::setZRange, py::arg("first"), py::arg("last"))
+        .def("addModel", &slm::LayerFilter::addModel, py::arg("mid"));
+
+    py::class_<slm::PrefetchStats>(m, "PrefetchStats")
+        .def(py::init())
+        .def_readonly("depth", &slm::PrefetchStats::depth)
+        .def_readonly("queueSize", &slm::PrefetchStats::queueSize)
+        .def_readonly("maxQueueSize", &slm::PrefetchStats::maxQueueSize)
+        .def_readonly("numDecoded", &slm::PrefetchStats::numDecoded)
+        .def_readonly("numConsumed", &slm::PrefetchStats::numConsumed)
+        .def_readonly("consumerStalls", &slm::PrefetchStats::consumerStalls)
+        .def_readonly("consumerStallTime", &slm::PrefetchStats::consumerStallTime)
+        .def_readonly("producerStalls", &slm::PrefetchStats::producerStalls)
+        .def_readonly("producerStallTime", &slm::PrefetchStats::producerStallTime);
+
     py::class_<slm::base::Reader, PyReader>(m, "Reader")
         .def(py::init())
         .def("setFilePath", &slm::base::Reader::setFilePath, py::arg("filename"))
         .def("getFilePath", &slm::base::Reader::getFilePath)
         .def("parse", &slm::base::Reader::parse)
+        .def("parseMetadata", &slm::base::Reader::parseMetadata)
+        .def("parseFiltered", &slm::base::Reader::parseFiltered, py::arg("filter"))
+        .def("refresh", &slm::base::Reader::refresh)
+        .def_property_readonly("summary", &slm::base::Reader::getSummary)
         .def("getFileSize", &slm::base::Reader::getFileSize)
         .def("getLayerThickness", &slm::base::Reader::getLayerThickness)
         .def("getModelById", &slm::base::Reader::getModelById, py::arg("mid"))
+        .def_property("numThreads", &slm::base::Reader::numThreads, &slm::base::Reader::setNumThreads)
+        .def_property("lazyLoading", &slm::base::Reader::isLazyLoading, &slm::base::Reader::setLazyLoading)
+        .def_property("memoryBudget", &slm::base::Reader::memoryBudget, &slm::base::Reader::setMemoryBudget)
+        .def_property_readonly("loadedMemory", &slm::base::Reader::loadedMemory)
+        .def("visitLayers", &slm::base::Reader::visitLayers, py::arg("visitor"),
+             "Streams each layer of the build to visitor(layer, models) without storing the layers. "
+             "Returning False from the visitor stops reading further layers.")
+        .def("startPrefetch", &slm::base::Reader::startPrefetch, py::arg("depth") = 8)
+        .def("nextLayer", &slm::base::Reader::nextLayer)
+        .def("stopPrefetch", &slm::base::Reader::stopPrefetch)
+        .def_property_readonly("isPrefetching", &slm::base::Reader::isPrefetching)
+        .def_property_readonly("hasPrefetchFailed", &slm::base::Reader::hasPrefetchFailed)
+        .def_property_readonly("prefetchStats", &slm::base::Reader::prefetchStats)
         .def_property_readonly("layers", &slm::base::Reader::getLayers)
         .def_property_readonly("models", &slm::base::Reader::getModels);
 
@@ -106,7 +164,42 @@ PYBIND11_MODULE(slm, m) {
         .def("getTotalNumContours", &slm::base::Writer::getTotalNumContours)
         .def("getBoundingBox", &slm::base::Writer::getBoundingBox)
         .def_property("sortLayers", &slm::base::Writer::isSortingLayers, &slm::base::Writer::setSortLayers)
-        .def("write", &slm::base::Writer::write, py::arg("header"), py::arg("models"), py::arg("layers"));
+        .def("write", &slm::base::Writer::write, py::arg("header"), py::arg("models"), py::arg("layers"))
+        .def("begin", &slm::base::Writer::begin, py::arg("header"), py::arg("models"))
+        .def("appendLayer", &slm::base::Writer::appendLayer, py::arg("layer"))
+        .def("finish", &slm::base::Writer::finish)
+        .def_property_readonly("isStreaming", &slm::base::Writer::isStreaming)
+        .def_property_readonly("hasWriteFailed", &slm::base::Writer::hasWriteFailed);
+
+    py::class_<slm::NativeReader, slm::base::Reader>(m, "NativeReader")
+        .def(py::init())
+        .def(py::init<std::string>())
+        .def_property_readonly("header", &slm::NativeReader::getHeader)
+        .def_static("isNativeFile", &slm::NativeReader::isNativeFile, py::arg("filename"));
+
+    py::class_<slm::NativeWriter, slm::base::Writer>(m, "NativeWriter")
+        .def(py::init())
+        .def(py::init<std::string>())
+        .def_property("layerThickness", &slm::NativeWriter::getLayerThickness, &slm::NativeWriter::setLayerThickness);
+
+    py::class_<slm::BuildCache, std::shared_ptr<slm::BuildCache>>(m, "BuildCache")
+        .def(py::init<const std::string &, uint64_t>(), py::arg("cacheDir"), py::arg("maxSize") = 0)
+        .def("open", [](slm::BuildCache &self, const slm::base::Reader::Ptr &reader, const std::string &format) {
+                return self.open(reader, format);
+            }, py::arg("reader"), py::arg("format"))
+        .def("open", [](slm::BuildCache &self, const slm::base::Reader::Ptr &reader, const std::string &format,
+                        const Header &header) {
+                return self.open(reader, format, header);
+            }, py::arg("reader"), py::arg("format"), py::arg("header"))
+        .def("key", &slm::BuildCache::key, py::arg("path"), py::arg("format"))
+        .def("contains", &slm::BuildCache::contains, py::arg("key"))
+        .def("remove", &slm::BuildCache::remove, py::arg("key"))
+        .def("clear", &slm::BuildCache::clear)
+        .def("entryPath", &slm::BuildCache::entryPath, py::arg("key"))
+        .def_property_readonly("cacheDir", &slm::BuildCache::cacheDir)
+        .def_property("maxSize", &slm::BuildCache::maxSize, &slm::BuildCache::setMaxSize)
+        .def_property_readonly("totalSize", &slm::BuildCache::totalSize)
+        .def_property_readonly("numEntries", &slm::BuildCache::numEntries);
 
 #endif
 
@@ -242,6 +335,49 @@ PYBIND11_MODULE(slm, m) {
         .value("Hatch", slm::LayerGeometry::TYPE::HATCH)
         .export_values();
 
+    py::class_<slm::GeometryStore, std::shared_ptr<slm::GeometryStore>>(m, "GeometryStore")
+        .def(py::init<uint32_t>(), py::arg("dim") = 2)
+        .def("__len__", &GeometryStore::size)
+        .def("clear", &GeometryStore::clear)
+        .def_property_readonly("dimension", &GeometryStore::dimension)
+        .def_property_readonly("numPoints", &GeometryStore::numPoints)
+        .def_property_readonly("isExternal", &GeometryStore::isExternal)
+        .def("append", (int64_t (GeometryStore::*)(const LayerGeometry &)) &GeometryStore::append, py::arg("geom"))
+        .def("__getitem__", [](const GeometryStore &store, size_t idx) {
+                // Return a copy of the coordinates of the block, as the storage may be reallocated when appending
+                if(idx >= store.size())
+                    throw py::index_error();
+
+                const GeometryView view = store.at(idx);
+                return py::array_t<float>(
+                    {view.rows, view.cols},  // shape
+                    {sizeof(float), sizeof(float) * view.rows},  // strides (column-major)
+                    view.data  // data pointer, copied without a parent object
+                );
+            })
+        .def("getGeometry", &GeometryStore::createGeometry, py::arg("idx"))
+        // The arrays are copies, as the storage of the store may be reallocated when geometry is appended
+        .def_property_readonly("coords", [](const GeometryStore &store) {
+                return py::array_t<float>({store.numPoints() * store.dimension()}, {sizeof(float)}, store.coordData());
+            })
+        .def_property_readonly("types", [](const GeometryStore &store) {
+                return py::array_t<uint8_t>({store.size()}, {sizeof(uint8_t)}, store.typeData());
+            })
+        .def_property_readonly("mid", [](const GeometryStore &store) {
+                return py::array_t<uint32_t>({store.size()}, {sizeof(uint32_t)}, store.modelIdData());
+            })
+        .def_property_readonly("bid", [](const GeometryStore &store) {
+                return py::array_t<uint32_t>({store.size()}, {sizeof(uint32_t)}, store.buildStyleIdData());
+            })
+        .def_property_readonly("offsets", [](const GeometryStore &store) {
+                return py::array_t<uint64_t>({store.size()}, {sizeof(uint64_t)}, store.offsetData());
+            })
+        .def_property_readonly("lengths", [](const GeometryStore &store) {
+                return py::array_t<uint64_t>({store.size()}, {sizeof(uint64_t)}, store.lengthData());
+            })
+        .def_static("fromGeometry", &GeometryStore::fromGeometry, py::arg("geoms"))
+        .def_static("compactLayers", &GeometryStore::compactLayers, py::arg("layers"));
+
      slm::bind_my_vector<std::vector<slm::BuildStyle::Ptr>>(m, "VectorBuildStyle");
      slm::bind_my_vector<std::vector<slm::LayerGeometry::Ptr>>(m, "VectorLayerGeometry");
 
@@ -368,9 +504,12 @@ PYBIND11_MODULE(slm, m) {
         .def(py::init<uint64_t, uint64_t>(), py::arg("mid"), py::arg("topSliceNum"))
         .def_property("mid", &Model::getId, &Model::setId)
         .def("__len__", [](const Model &s ) { return s.getBuildStyles().size(); })
-        .def_property("buildStyles",py::cpp_function(&slm::Model::buildStylesRef,py::return_value_policy::reference, py::keep_alive<1,0>()),
-                                    py::cpp_function(&slm::Model::setBuildStyles, py::keep_alive<1, 2>()))
-        //.def_property("buildStyles", &Model::getBuildStyles, &Model::setBuildStyles)
+        // The build styles are returned as a copy, so that reading them retains the index of the build styles by id
+        .def_property("buildStyles", &Model::getBuildStyles,
+                                     py::cpp_function(&slm::Model::setBuildStyles, py::keep_alive<1, 2>()))
+        .def("addBuildStyle", &Model::addBuildStyle, py::arg("bstyle"))
+        .def("getBuildStyleById", &Model::getBuildStyleById, py::arg("bid"))
+        .def("reindexBuildStyles", &Model::reindexBuildStyles)
         .def_property("topLayerId",  &Model::getTopSlice, &Model::setTopSlice)
         .def_property("name", &Model::getName, &Model::setName)
         .def_property("buildStyleName", &Model::getBuildStyleName, &Model::setBuildStlyeName)
@@ -407,16 +546,23 @@ PYBIND11_MODULE(slm, m) {
     py::class_<slm::Layer, std::shared_ptr<slm::Layer>>(m, "Layer", py::dynamic_attr())
         .def(py::init())
         .def(py::init<uint64_t, uint64_t>(), py::arg("id"), py::arg("z"))
-        .def("__len__", [](const Layer &s ) { return s.geometry().size(); })
+        .def("__len__", [](const Layer &s ) { return s.numGeometry(); })
         .def_property_readonly("layerFilePosition", &Layer::layerFilePosition)
         .def("isLoaded", &Layer::isLoaded)
+        .def("unload", &Layer::unload)
+        .def_property_readonly("memoryUsage", &Layer::memoryUsage)
         .def("getPointsGeometry", &Layer::getPntsGeometry)
         .def("getHatchGeometry", &Layer::getHatchGeometry)
         .def("getContourGeometry", &Layer::getContourGeometry)
+        .def("numGeometryByType", &Layer::numGeometryByType, py::arg("type"))
         .def("appendGeometry", &Layer::appendGeometry,  py::keep_alive<1, 2>())
        // .def("geom", [](Layer &v) { return &(v.geometry()); }, py::keep_alive<1,0>())
         .def_property("geometry",py::cpp_function(&Layer::geometryRef,py::return_value_policy::reference, py::keep_alive<1,0>()),
                                  py::cpp_function(&Layer::setGeometry, py::keep_alive<1, 2>()))
+        .def_property("geometryStore", &Layer::geometryStore,
+                                       [](Layer &self, GeometryStore::Ptr store) { self.setGeometryStore(store); })
+        .def("setGeometryStore", &Layer::setGeometryStore, py::arg("store"), py::arg("first") = 0, py::arg("count") = SIZE_MAX)
+        .def("compactGeometry", &Layer::compactGeometry)
         .def_property("z", &Layer::getZ, &Layer::setZ)
         .def_property("layerId", &Layer::getLayerId, &Layer::setLayerId)
         .def("getGeometry", &Layer::getGeometry, py::arg("scanMode") = slm::ScanMode::NONE)
@@ -440,6 +586,204 @@ PYBIND11_MODULE(slm, m) {
                 }
             ));
 
+    py::class_<slm::LayerStatistics>(m, "LayerStatistics")
+        .def(py::init())
+        .def_readonly("layerId", &LayerStatistics::layerId)
+        .def_readonly("zMin", &LayerStatistics::zMin)
+        .def_readonly("zMax", &LayerStatistics::zMax)
+        .def_readonly("numPoints", &LayerStatistics::numPoints)
+        .def_readonly("scanLength", &LayerStatistics::scanLength)
+        .def_property_readonly("boundingBox", [](const LayerStatistics &self) {
+                return std::make_tuple(self.bbox[0], self.bbox[1], self.bbox[2], self.bbox[3]);
+            })
+        .def("numGeometryByType", &LayerStatistics::numGeometryByType, py::arg("type"));
+
+    py::class_<slm::BuildStatistics>(m, "BuildStatistics")
+        .def(py::init())
+        .def(py::init<const std::vector<Layer::Ptr> &, int>(), py::arg("layers"), py::arg("numThreads") = 0)
+        .def("compute", &BuildStatistics::compute, py::arg("layers"), py::arg("numThreads") = 0)
+        .def_property_readonly("total", &BuildStatistics::total)
+        .def_property_readonly("layers", &BuildStatistics::layers)
+        .def_property_readonly("numLayers", &BuildStatistics::numLayers)
+        .def_static("computeLayer", &BuildStatistics::computeLayer, py::arg("layer"));
+
+    py::class_<slm::ValidationIssue> validationIssue(m, "ValidationIssue");
+
+    py::enum_<slm::ValidationIssue::CODE>(validationIssue, "CODE")
+        .value("NON_FINITE_COORDINATE", ValidationIssue::NON_FINITE_COORDINATE)
+        .value("ODD_HATCH_POINTS", ValidationIssue::ODD_HATCH_POINTS)
+        .value("MISSING_MODEL", ValidationIssue::MISSING_MODEL)
+        .value("MISSING_BUILD_STYLE", ValidationIssue::MISSING_BUILD_STYLE)
+        .value("NON_MONOTONIC_Z", ValidationIssue::NON_MONOTONIC_Z)
+        .value("DUPLICATE_LAYER_ID", ValidationIssue::DUPLICATE_LAYER_ID)
+        .export_values();
+
+    validationIssue
+        .def_readonly("code", &ValidationIssue::code)
+        .def_readonly("layerIdx", &ValidationIssue::layerIdx)
+        .def_readonly("layerId", &ValidationIssue::layerId)
+        .def_readonly("geometryIdx", &ValidationIssue::geometryIdx)
+        .def("message", &ValidationIssue::message)
+        .def("__repr__", [](const ValidationIssue &self) {
+                return "<libSLM.ValidationIssue '" + self.message() + "'>";
+            });
+
+    py::class_<slm::Validator>(m, "Validator")
+        .def(py::init())
+        .def("validate", &Validator::validate, py::arg("models"), py::arg("layers"), py::arg("numThreads") = 0)
+        .def("clear", &Validator::clear)
+        .def_property_readonly("isValid", &Validator::isValid)
+        .def_property_readonly("issues", &Validator::issues)
+        .def_property_readonly("numIssues", &Validator::numIssues)
+        .def("numIssuesByCode", &Validator::numIssuesByCode, py::arg("code"));
+
+    py::class_<slm::Build, std::shared_ptr<slm::Build>>(m, "Build")
+        .def(py::init())
+        .def(py::init<const Header &, const std::vector<Model::Ptr> &, const std::vector<Layer::Ptr> &>(),
+             py::arg("header"), py::arg("models"), py::arg("layers"))
+        .def_property("header", &Build::header, &Build::setHeader)
+        .def_property("models", &Build::models, &Build::setModels)
+        .def_property("layers", &Build::layers, &Build::setLayers)
+        .def_property_readonly("layersByZ", &Build::layersByZ)
+        .def_property_readonly("numModels", &Build::numModels)
+        .def_property_readonly("numLayers", &Build::numLayers)
+        .def_property_readonly("numDuplicateModels", &Build::numDuplicateModels)
+        .def_property_readonly("numDuplicateLayers", &Build::numDuplicateLayers)
+        .def("clear", &Build::clear)
+        .def("reindex", &Build::reindex)
+        .def("addModel", &Build::addModel, py::arg("model"))
+        .def("removeModel", &Build::removeModel, py::arg("mid"))
+        .def("getModelById", &Build::getModelById, py::arg("mid"))
+        .def("getBuildStyle", &Build::getBuildStyle, py::arg("mid"), py::arg("bid"))
+        .def("addLayer", &Build::addLayer, py::arg("layer"))
+        .def("removeLayer", &Build::removeLayer, py::arg("layerId"))
+        .def("getLayerById", &Build::getLayerById, py::arg("layerId"))
+        .def("getLayerByZ", &Build::getLayerByZ, py::arg("z"))
+        .def("getLayersInZRange", &Build::getLayersInZRange, py::arg("zMin"), py::arg("zMax"))
+        .def("getTopLayerByPosition", [](const Build &self) { return self.getTopLayerByPosition(); })
+        .def("getTopLayerById", [](const Build &self) { return self.getTopLayerById(); });
+
+    py::class_<slm::BuildStyleParameters>(m, "BuildStyleParameters")
+        .def(py::init())
+        .def_readonly("mid", &BuildStyleParameters::mid)
+        .def_readonly("bid", &BuildStyleParameters::bid)
+        .def_readonly("laserId", &BuildStyleParameters::laserId)
+        .def_readonly("laserMode", &BuildStyleParameters::laserMode)
+        .def_readonly("laserPower", &BuildStyleParameters::laserPower)
+        .def_readonly("laserFocus", &BuildStyleParameters::laserFocus)
+        .def_readonly("laserSpeed", &BuildStyleParameters::laserSpeed)
+        .def_readonly("pointDistance", &BuildStyleParameters::pointDistance)
+        .def_readonly("pointDelay", &BuildStyleParameters::pointDelay)
+        .def_readonly("pointExposureTime", &BuildStyleParameters::pointExposureTime)
+        .def_readonly("jumpSpeed", &BuildStyleParameters::jumpSpeed)
+        .def_readonly("jumpDelay", &BuildStyleParameters::jumpDelay);
+
+    py::class_<slm::BuildStyleTable> buildStyleTable(m, "BuildStyleTable");
+
+    buildStyleTable
+        .def(py::init())
+        .def(py::init<const std::vector<Model::Ptr> &>(), py::arg("models"))
+        .def("build", &BuildStyleTable::build, py::arg("models"))
+        .def("clear", &BuildStyleTable::clear)
+        .def("indexOf", &BuildStyleTable::indexOf, py::arg("mid"), py::arg("bid"))
+        .def("at", &BuildStyleTable::at, py::arg("idx"))
+        .def_property_readonly("parameters", &BuildStyleTable::parameters)
+        .def("__len__", &BuildStyleTable::size)
+        .def("resolveLayer", [](const BuildStyleTable &self, const Layer &layer, ScanMode mode) {
+                std::vector<uint32_t> styleIdx;
+                self.resolveLayer(layer, mode, styleIdx);
+                return styleIdx;
+            }, py::arg("layer"), py::arg("mode") = slm::NONE);
+
+    buildStyleTable.attr("InvalidIndex") = BuildStyleTable::InvalidIndex;
+
+    py::class_<slm::LaserStateSeries>(m, "LaserStateSeries")
+        .def(py::init())
+        .def("__len__", &LaserStateSeries::size)
+        .def_readonly("time", &LaserStateSeries::time)
+        .def_readonly("position", &LaserStateSeries::position)
+        .def_readonly("velocity", &LaserStateSeries::velocity)
+        .def_readonly("power", &LaserStateSeries::power)
+        .def_readonly("exposureTime", &LaserStateSeries::exposureTime)
+        .def_readonly("pointDistance", &LaserStateSeries::pointDistance)
+        .def_readonly("layer", &LaserStateSeries::layer)
+        .def_readonly("laserOn", &LaserStateSeries::laserOn);
+
+    py::class_<slm::LaserScan>(m, "LaserScan")
+        .def(py::init())
+        .def_readonly("start", &LaserScan::start)
+        .def_readonly("end", &LaserScan::end)
+        .def_readonly("tStart", &LaserScan::tStart)
+        .def_readonly("tEnd", &LaserScan::tEnd)
+        .def_readonly("layer", &LaserScan::layer)
+        .def_readonly("mid", &LaserScan::mid)
+        .def_readonly("bid", &LaserScan::bid)
+        .def_readonly("type", &LaserScan::type);
+
+    py::class_<slm::Slm>(m, "Slm")
+        .def(py::init())
+        .def("setBuild", &Slm::setBuild, py::arg("layers"), py::arg("models"), py::arg("mode"),
+             py::arg("layerThickness"), py::arg("layerAdditionTime") = 0., py::arg("layerCoolingTime") = 0.)
+        .def("clear", &Slm::clear)
+        .def_property("layerCoolingTime", &Slm::getLayerCoolingTime, &Slm::setLayerCoolingTime)
+        .def_property("layerAdditionTime", &Slm::getLayerAdditionTime, &Slm::setLayerAdditionTime)
+        .def_property_readonly("layerThickness", &Slm::getLayerThickness)
+        .def_property("numThreads", &Slm::getNumThreads, &Slm::setNumThreads)
+        .def_property("cacheArcLengths", &Slm::getCacheArcLengths, &Slm::setCacheArcLengths)
+        .def("precomputeArcLengths", &Slm::precomputeArcLengths)
+        .def_property_readonly("numLayers", &Slm::numLayers)
+        .def_property_readonly("scanMode", &Slm::getScanMode)
+        .def_property_readonly("layers", &Slm::getLayers)
+        .def_property_readonly("models", &Slm::getModels)
+        .def_property_readonly("buildTime", &Slm::getBuildTime)
+        .def_property_readonly("buildEnergy", &Slm::getBuildEnergy)
+        .def("getLayerIdByTime", &Slm::getLayerIdByTime, py::arg("time"))
+        .def("getLayerByTime", &Slm::getLayerByTime, py::arg("time"))
+        .def("getTimeByLayerId", &Slm::getTimeByLayerId, py::arg("layerId"))
+        .def("getTimeByLayerGeomId", &Slm::getTimeByLayerGeomId, py::arg("layerId"), py::arg("geomId"))
+        .def("getLayerScanTime", &Slm::getLayerScanTime, py::arg("layerId"))
+        .def("getGeomIdByTime", [](const Slm &self, double t) {
+                int layerId = -1, geomId = -1;
+                self.getGeomIdByTime(t, layerId, geomId);
+                return std::make_tuple(layerId, geomId);
+            }, py::arg("time"))
+        .def("getLayerGeometryByTime", &Slm::getLayerGeometryByTime, py::arg("time"))
+        .def("isLaserOnByTime", &Slm::isLaserOnByTime, py::arg("time"))
+        .def("getLaserPosition", [](const Slm &self, double t) {
+                double x = 0., y = 0., z = 0.;
+                bool isLaserOn = false;
+                self.getLaserPosition(t, x, y, z, isLaserOn);
+                return std::make_tuple(x, y, z, isLaserOn);
+            }, py::arg("time"))
+        .def("getLaserVelocity", [](const Slm &self, double t) {
+                double dx = 0., dy = 0.;
+                bool isLaserOn = false;
+                self.getLaserVelocity(t, dx, dy, isLaserOn);
+                return std::make_tuple(dx, dy, isLaserOn);
+            }, py::arg("time"))
+        .def("getLaserParameters", [](const Slm &self, double t) {
+                float power = 0.f;
+                int expTime = 0, pntDist = 0;
+                bool isLaserOn = false;
+                self.getLaserParameters(t, power, expTime, pntDist, isLaserOn);
+                return std::make_tuple(power, expTime, pntDist, isLaserOn);
+            }, py::arg("time"))
+        .def("sampleLaserState", [](const Slm &self, const Eigen::ArrayXd &times) {
+                LaserStateSeries series;
+                self.sampleLaserState(times, series);
+                return series;
+            }, py::arg("times"))
+        .def("sampleLaserState", [](const Slm &self, double t0, double dt, uint64_t n) {
+                LaserStateSeries series;
+                self.sampleLaserState(t0, dt, n, series);
+                return series;
+            }, py::arg("t0"), py::arg("dt"), py::arg("n"))
+        .def("getLaserScansByTime", [](const Slm &self, double t0, double t1) {
+                std::vector<LaserScan> scans;
+                self.getLaserScansByTime(t0, t1, scans);
+                return scans;
+            }, py::arg("t0"), py::arg("t1"));
+
 #ifdef PROJECT_VERSION
     m.attr("__version__") = "PROJECT_VERSION";
 #else
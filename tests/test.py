@@ -1,4 +1,394 @@
+import os
+import shutil
+import tempfile
+
+import numpy as np
+
 import libSLM as slm
 
 assert slm.__version__ == '0.0.1'
 
+"""
+Fixture of two layers scanned with a single build style at 10 mm/s. The first layer has two hatch vectors of length
+10 (2.0 s) and the second a contour of length 3 + 4 (0.7 s). With an addition time of 1.0 s and a cooling time of
+0.5 s, the second layer starts at 2.0 + 1.5 = 3.5 s and the build ends at 3.5 + 0.7 + 0.5 = 4.7 s.
+"""
+
+
+def createGeometry(geomType, coords):
+    geom = geomType(mid=1, bid=1)
+    # The coordinates are copied directly into the column-major storage of the geometry
+    geom.coords = np.asfortranarray(coords, dtype=np.float32)
+    return geom
+
+
+def createFixture():
+    bstyle = slm.BuildStyle()
+    bstyle.setStyle(bid=1, focus=0.0, power=200.0, pointExposureTime=80, pointExposureDistance=50, speed=10.0)
+
+    model = slm.Model(mid=1, topSliceNum=0)
+    model.buildStyles = [bstyle]
+
+    layer0 = slm.Layer(id=0, z=0)
+    layer0.appendGeometry(createGeometry(slm.HatchGeometry, [[0, 0], [10, 0], [0, 1], [10, 1]]))
+
+    layer1 = slm.Layer(id=1, z=30)
+    layer1.appendGeometry(createGeometry(slm.ContourGeometry, [[0, 0], [3, 0], [3, 4]]))
+
+    return [model], [layer0, layer1]
+
+
+def createSlm(models, layers):
+    sim = slm.Slm()
+    sim.setBuild(layers, models, slm.ScanMode.Default, 0.03, 1.0, 0.5)
+    return sim
+
+
+def createHeader(filename):
+    header = slm.Header()
+    header.filename = filename
+    header.creator = 'libSLM'
+    header.version = (1, 0)
+    header.zUnit = 1000
+    return header
+
+
+def writeNative(path, models, layers):
+    header = createHeader('fixture')
+
+    writer = slm.NativeWriter(path)
+    writer.layerThickness = 0.03
+    writer.write(header, models, layers)
+
+
+def test_buildTime():
+    models, layers = createFixture()
+    sim = createSlm(models, layers)
+
+    assert np.isclose(sim.buildTime, 4.7)
+    assert np.isclose(sim.getTimeByLayerId(1), 3.5)
+    assert np.isclose(sim.getLayerScanTime(0), 2.0)
+    assert np.isclose(sim.getLayerScanTime(1), 0.7)
+
+
+def test_layerIdByTime():
+    models, layers = createFixture()
+    sim = createSlm(models, layers)
+
+    # The next layer is added once the previous layer has been scanned and cooled at 2.5 s
+    expected = {1.0: 0, 2.4: 0, 2.6: 1, 4.0: 1, 4.6: 1, 4.8: -1}
+
+    for t, layerId in expected.items():
+        assert sim.getLayerIdByTime(t) == layerId
+
+
+def test_laserPosition():
+    models, layers = createFixture()
+    sim = createSlm(models, layers)
+
+    # Halfway along the first and second hatch vectors, between the layers and 2 mm along the second contour edge
+    expected = {0.5: (5.0, 0.0, 0.0), 1.5: (5.0, 1.0, 0.0), 4.0: (3.0, 2.0, 0.03)}
+
+    for t, pos in expected.items():
+        x, y, z, isLaserOn = sim.getLaserPosition(t)
+        assert isLaserOn
+        assert np.allclose((x, y, z), pos)
+
+    assert not sim.getLaserPosition(2.2)[3]
+    assert not sim.getLaserPosition(4.8)[3]
+
+
+def test_sampleLaserState():
+    models, layers = createFixture()
+    sim = createSlm(models, layers)
+
+    times = np.array([0.5, 1.5, 2.2, 4.0, 4.8])
+    series = sim.sampleLaserState(times)
+
+    assert len(series) == len(times)
+    assert list(series.laserOn) == [True, True, False, True, False]
+    assert list(series.layer) == [0, 0, 0, 1, -1]
+    assert np.allclose(series.power, [200.0, 200.0, 0.0, 200.0, 0.0])
+    assert np.allclose(series.position, [[5, 0, 0], [5, 1, 0], [0, 0, 0], [3, 2, 0.03], [0, 0, 0]])
+    assert np.allclose(series.velocity, [[10, 0], [10, 0], [0, 0], [0, 10], [0, 0]])
+
+    # Samples at a fixed increment match the individual queries
+    series = sim.sampleLaserState(t0=0.0, dt=0.05, n=94)
+
+    for i in range(len(series)):
+        x, y, z, isLaserOn = sim.getLaserPosition(series.time[i])
+        assert series.laserOn[i] == isLaserOn
+
+        if isLaserOn:
+            assert np.allclose(series.position[i], (x, y, z), atol=1e-5)
+
+
+def test_nativeRoundTrip():
+    models, layers = createFixture()
+    tmpDir = tempfile.mkdtemp()
+
+    try:
+        path = os.path.join(tmpDir, 'fixture.slmn')
+        writeNative(path, models, layers)
+
+        reader = slm.NativeReader(path)
+        assert reader.parse() > 0
+
+        assert reader.header.zUnit == 1000
+        assert np.isclose(reader.getLayerThickness(), 0.03)
+
+        assert len(reader.models) == 1
+        bstyle = reader.models[0].buildStyles[0]
+        assert (bstyle.bid, bstyle.laserPower, bstyle.laserSpeed) == (1, 200.0, 10.0)
+
+        assert len(reader.layers) == len(layers)
+
+        for layer, ref in zip(reader.layers, layers):
+            assert (layer.layerId, layer.z) == (ref.layerId, ref.z)
+
+            geoms, refGeoms = layer.getGeometry(), ref.getGeometry()
+            assert len(geoms) == len(refGeoms)
+
+            for geom, refGeom in zip(geoms, refGeoms):
+                assert (geom.type, geom.mid, geom.bid) == (refGeom.type, refGeom.mid, refGeom.bid)
+                assert np.array_equal(geom.coords, refGeom.coords)
+
+        # The build read back is simulated identically
+        assert np.isclose(createSlm(reader.models, reader.layers).buildTime, 4.7)
+
+    finally:
+        shutil.rmtree(tmpDir)
+
+
+def test_buildCache():
+    models, layers = createFixture()
+    tmpDir = tempfile.mkdtemp()
+
+    try:
+        path = os.path.join(tmpDir, 'source.slmn')
+        writeNative(path, models, layers)
+
+        cache = slm.BuildCache(os.path.join(tmpDir, 'cache'))
+
+        # The first open translates the source, the second opens the cached entry
+        miss = cache.open(slm.NativeReader(path), 'native-1')
+        assert miss.getFilePath() == path
+        assert cache.numEntries == 1
+
+        hit = cache.open(slm.NativeReader(path), 'native-1')
+        assert hit.getFilePath() == cache.entryPath(cache.key(path, 'native-1'))
+        assert len(hit.layers) == len(layers)
+
+        # The header of the source build is retained by the cached build
+        assert (hit.header.filename, hit.header.zUnit) == ('fixture', 1000)
+
+        # The key depends on the format
+        assert cache.key(path, 'native-1') != cache.key(path, 'other-1')
+
+        # Changing the source misses the cache
+        layers.append(slm.Layer(id=2, z=60))
+        writeNative(path, models, layers)
+
+        changed = cache.open(slm.NativeReader(path), 'native-1')
+        assert changed.getFilePath() == path
+        assert len(changed.layers) == 3
+        assert cache.numEntries == 2
+
+    finally:
+        shutil.rmtree(tmpDir)
+
+
+def test_validateDuplicateLayerIds():
+    models, _ = createFixture()
+    layers = [slm.Layer(id=0, z=0), slm.Layer(id=1, z=30), slm.Layer(id=1, z=60)]
+
+    validator = slm.Validator()
+    assert not validator.validate(models, layers)
+    assert validator.numIssuesByCode(slm.ValidationIssue.CODE.DUPLICATE_LAYER_ID) == 1
+    assert validator.issues[0].layerIdx == 2
+
+
+def test_buildDuplicateIds():
+    models, _ = createFixture()
+    models.append(slm.Model(mid=1, topSliceNum=5))
+
+    layers = [slm.Layer(id=0, z=0), slm.Layer(id=1, z=30), slm.Layer(id=1, z=60)]
+
+    build = slm.Build(slm.Header(), models, layers)
+
+    # Every entry is retained, whilst lookups by id return the first
+    assert build.numLayers == 3
+    assert build.numModels == 2
+    assert build.numDuplicateLayers == 1
+    assert build.numDuplicateModels == 1
+    assert build.getLayerById(1).z == 30
+    assert build.getModelById(1).topLayerId == 0
+    assert build.reindex() == 2
+
+    # Removing the indexed layer indexes the following layer of the same id
+    assert build.removeLayer(1)
+    assert build.getLayerById(1).z == 60
+    assert build.numDuplicateLayers == 0
+
+
+def test_buildTopLayer():
+    build = slm.Build(slm.Header(), [], [slm.Layer(id=0, z=0), slm.Layer(id=1, z=30)])
+
+    assert build.getTopLayerById().layerId == 1
+    assert build.getTopLayerByPosition().z == 30
+
+    # A remaining layer with an id and z position of 0 is the top layer, as when the layers are set
+    assert build.removeLayer(1)
+    assert build.getTopLayerById().layerId == 0
+    assert build.getTopLayerByPosition().z == 0
+
+    build.layers = build.layers
+    assert build.getTopLayerById().layerId == 0
+
+
+def test_refreshFiltered():
+    models, _ = createFixture()
+    layers = []
+
+    for i in range(6):
+        layer = slm.Layer(id=i, z=30 * i)
+        layer.appendGeometry(createGeometry(slm.HatchGeometry, [[0, i], [10, i]]))
+        layers.append(layer)
+
+    header = createHeader('growing')
+
+    tmpDir = tempfile.mkdtemp()
+
+    try:
+        path = os.path.join(tmpDir, 'growing.slmn')
+
+        def writeUnfinished(numLayers):
+            # The build is left unfinished as if still being written, and is flushed once the writer is released
+            writer = slm.NativeWriter(path)
+            writer.begin(header, models)
+
+            for layer in layers[:numLayers]:
+                writer.appendLayer(layer)
+
+            del writer
+
+        layerFilter = slm.LayerFilter()
+        layerFilter.setLayerIdRange(1, 4)
+
+        writeUnfinished(3)
+
+        reader = slm.NativeReader(path)
+        assert reader.parseFiltered(layerFilter) > 0
+        assert [layer.layerId for layer in reader.layers] == [1, 2]
+
+        # Only the appended layers selected by the filter are added after those already parsed
+        writeUnfinished(6)
+
+        assert reader.refresh() == 2
+        assert [layer.layerId for layer in reader.layers] == [1, 2, 3, 4]
+        assert all(len(layer) == 1 for layer in reader.layers)
+
+        assert reader.refresh() == 0
+
+    finally:
+        shutil.rmtree(tmpDir)
+
+
+def test_modelBuildStyles():
+    models, _ = createFixture()
+    model = models[0]
+
+    # Reading the build styles returns a copy, which leaves the index of the model unchanged
+    assert len(model.buildStyles) == 1
+    assert model.getBuildStyleById(1).laserSpeed == 10.0
+
+    bstyle = slm.BuildStyle()
+    bstyle.setStyle(bid=2, focus=0.0, power=100.0, pointExposureTime=80, pointExposureDistance=50, speed=20.0)
+
+    assert model.addBuildStyle(bstyle) == 2
+    assert model.addBuildStyle(bstyle) == -1
+    assert model.getBuildStyleById(2).laserSpeed == 20.0
+    assert model.getBuildStyleById(3) is None
+    assert len(model) == 2
+
+
+def test_visitLayers():
+    models, layers = createFixture()
+    tmpDir = tempfile.mkdtemp()
+
+    try:
+        path = os.path.join(tmpDir, 'fixture.slmn')
+        writeNative(path, models, layers)
+
+        reader = slm.NativeReader(path)
+        assert reader.parse() > 0
+
+        visited = []
+
+        def visitor(layer, visitModels):
+            visited.append((layer.layerId, len(layer), len(visitModels)))
+            return True
+
+        assert reader.visitLayers(visitor) == 2
+        assert visited == [(0, 1, 1), (1, 1, 1)]
+
+        # The build parsed by the reader is unchanged
+        assert len(reader.layers) == 2
+        assert len(reader.models) == 1
+        assert reader.refresh() == 0
+
+        # Returning False stops after the first layer
+        assert reader.visitLayers(lambda layer, visitModels: False) == 1
+
+        # Exceptions raised by the visitor are propagated
+        def failingVisitor(layer, visitModels):
+            raise ValueError('visitor failed')
+
+        try:
+            reader.visitLayers(failingVisitor)
+            assert False
+        except ValueError:
+            pass
+
+        assert len(reader.models) == 1
+
+    finally:
+        shutil.rmtree(tmpDir)
+
+
+def test_writeFailure():
+    models, layers = createFixture()
+    tmpDir = tempfile.mkdtemp()
+
+    try:
+        path = os.path.join(tmpDir, 'fixture.slmn')
+
+        writer = slm.NativeWriter(path)
+        writer.write(createHeader('fixture'), models, layers)
+        assert not writer.hasWriteFailed
+
+        # The directory of the file does not exist, so the file cannot be created
+        writer = slm.NativeWriter(os.path.join(tmpDir, 'missing', 'fixture.slmn'))
+        writer.write(createHeader('fixture'), models, layers)
+        assert writer.hasWriteFailed
+
+        assert writer.begin(createHeader('fixture'), models) < 0
+
+    finally:
+        shutil.rmtree(tmpDir)
+
+
+if __name__ == '__main__':
+    test_buildTime()
+    test_layerIdByTime()
+    test_laserPosition()
+    test_sampleLaserState()
+    test_nativeRoundTrip()
+    test_buildCache()
+    test_validateDuplicateLayerIds()
+    test_buildDuplicateIds()
+    test_refreshFiltered()
+    test_modelBuildStyles()
+    test_visitLayers()
+    test_writeFailure()
+    test_buildTopLayer()